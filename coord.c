@@ -0,0 +1,156 @@
+#define _GNU_SOURCE     // posix_memalign, sched_yield under -std=c99
+
+#include <stdlib.h>     // posix_memalign, free
+#include <string.h>     // memset, strcmp
+#include <sched.h>      // sched_yield
+#include "sync.h"       // CPU_RELAX
+#include "coord.h"
+
+#define COORD_OP_BOARD 0
+#define COORD_OP_UNBOARD 1
+#define COORD_SPIN_LIMIT 64     // Spins before a waiting car yields its core
+
+static const char *kind_names[COORD_KINDS] = { "mutex", "atomic", "combining" };
+
+const char *coord_kind_name(coord_kind_t kind) {
+    return kind < COORD_KINDS ? kind_names[kind] : "unknown";
+}
+
+int coord_kind_parse(const char *name) {
+    for (int k = 0; k < COORD_KINDS; k++) {
+        if (strcmp(name, kind_names[k]) == 0) return k;
+    }
+    return -1;
+}
+
+int coord_init(board_coord_t *c, coord_kind_t kind, int capacity, int threads) {
+    memset(c, 0, sizeof(*c));
+    if (capacity < 1 || capacity > COORD_MAX_CAPACITY || threads < 1) return -1;
+    c->kind = kind;
+    c->capacity = capacity;
+    c->threads = threads;
+    if (kind == COORD_MUTEX) return pthread_mutex_init(&c->lock, NULL) == 0 ? 0 : -1;
+    if (kind == COORD_COMBINING) {
+        if (posix_memalign(&c->block, COORD_LINE, sizeof(coord_slot_t) * threads) != 0) return -1;
+        c->slots = c->block;
+        memset(c->slots, 0, sizeof(coord_slot_t) * threads);
+    }
+    return 0;
+}
+
+// --- SEQUENTIAL STEPS ---
+// The request applied by whoever owns the state: the mutex holder or the
+// combiner. The lowest free seat is taken, as the generic engine does.
+static int board_locked(board_coord_t *c) {
+    if (c->load == c->capacity) return -1;
+    int seat = __builtin_ctzll(~c->seats);
+    c->seats |= 1ULL << seat;
+    c->load++;
+    return seat;
+}
+
+static void unboard_locked(board_coord_t *c, int seat) {
+    c->seats &= ~(1ULL << seat);
+    c->load--;
+}
+
+// --- ATOMIC ---
+// The load is reserved first, so a car that got past it always finds a
+// free bit: an unboarding car clears its seat before it returns its load.
+static int board_atomic(board_coord_t *c) {
+    int load = __atomic_load_n(&c->load, __ATOMIC_RELAXED);
+    do {
+        if (load == c->capacity) return -1;
+    } while (!__atomic_compare_exchange_n(&c->load, &load, load + 1, 1,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    uint64_t seats = __atomic_load_n(&c->seats, __ATOMIC_RELAXED);
+    int seat;
+    do {
+        seat = __builtin_ctzll(~seats);
+    } while (!__atomic_compare_exchange_n(&c->seats, &seats, seats | 1ULL << seat, 1,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    return seat;
+}
+
+static void unboard_atomic(board_coord_t *c, int seat) {
+    __atomic_fetch_and(&c->seats, ~(1ULL << seat), __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&c->load, 1, __ATOMIC_RELEASE);
+}
+
+// --- FLAT COMBINING ---
+// Publishes the request, then either becomes the combiner or waits for
+// one to serve it. The combiner keeps scanning until a pass finds nothing
+// pending, so requests arriving during a pass are served by the next.
+// passes counts the scans that served something. A car whose request was
+// served while it waited for the flag simply returns.
+static int combine(board_coord_t *c, int thread, int op, int arg) {
+    coord_slot_t *mine = &c->slots[thread];
+    mine->op = op;
+    mine->arg = arg;
+    __atomic_store_n(&mine->pending, 1, __ATOMIC_RELEASE);
+
+    for (int spins = 0; __atomic_load_n(&mine->pending, __ATOMIC_ACQUIRE); ) {
+        if (__atomic_load_n(&c->combiner, __ATOMIC_RELAXED) == 0 &&
+            !__atomic_exchange_n(&c->combiner, 1, __ATOMIC_ACQUIRE)) {
+            unsigned long applied;
+            do {
+                applied = 0;
+                for (int t = 0; t < c->threads; t++) {
+                    coord_slot_t *slot = &c->slots[t];
+                    if (!__atomic_load_n(&slot->pending, __ATOMIC_ACQUIRE)) continue;
+                    if (slot->op == COORD_OP_BOARD) slot->result = board_locked(c);
+                    else unboard_locked(c, slot->arg);
+                    __atomic_store_n(&slot->pending, 0, __ATOMIC_RELEASE);
+                    applied++;
+                }
+                if (applied > 0) c->passes++;
+                c->combined += applied;
+            } while (applied > 0);
+            __atomic_store_n(&c->combiner, 0, __ATOMIC_RELEASE);
+        } else if (spins++ < COORD_SPIN_LIMIT) {
+            CPU_RELAX();
+        } else {
+            sched_yield();
+        }
+    }
+    return mine->result;
+}
+
+// --- DISPATCH ---
+int coord_board(board_coord_t *c, int thread) {
+    int seat;
+    switch (c->kind) {
+    case COORD_MUTEX:
+        pthread_mutex_lock(&c->lock);
+        seat = board_locked(c);
+        pthread_mutex_unlock(&c->lock);
+        return seat;
+    case COORD_ATOMIC:
+        return board_atomic(c);
+    default:
+        return combine(c, thread, COORD_OP_BOARD, 0);
+    }
+}
+
+void coord_unboard(board_coord_t *c, int thread, int seat) {
+    switch (c->kind) {
+    case COORD_MUTEX:
+        pthread_mutex_lock(&c->lock);
+        unboard_locked(c, seat);
+        pthread_mutex_unlock(&c->lock);
+        break;
+    case COORD_ATOMIC:
+        unboard_atomic(c, seat);
+        break;
+    default:
+        combine(c, thread, COORD_OP_UNBOARD, seat);
+        break;
+    }
+}
+
+void coord_destroy(board_coord_t *c) {
+    if (c->kind == COORD_MUTEX) pthread_mutex_destroy(&c->lock);
+    free(c->block);
+    c->block = NULL;
+    c->slots = NULL;
+}
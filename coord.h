@@ -0,0 +1,65 @@
+#ifndef COORD_H
+#define COORD_H
+
+#include <stdint.h>     // Seat bitmap word
+#include <pthread.h>    // Mutex coordinator
+
+// --- BOARDING COORDINATORS ---
+// The shared part of boarding and unboarding: the load counter and the
+// seat bitmap every car updates under the dock lock. Three ways to run it:
+//   mutex      every car takes one pthread mutex, as the simulator does
+//   atomic     the load is reserved with a CAS loop and the seat claimed
+//              with a CAS on the bitmap word; no lock at all
+//   combining  flat combining: a car publishes its request in its own
+//              cache-line slot, and whichever car wins the combiner flag
+//              applies every pending request in one pass while the others
+//              spin on their own slot. The load and seats then stay in the
+//              combiner's cache instead of bouncing between all the cars.
+// Seats fit one 64-bit word, so capacity is at most COORD_MAX_CAPACITY.
+typedef enum {
+    COORD_MUTEX,
+    COORD_ATOMIC,
+    COORD_COMBINING
+} coord_kind_t;
+
+#define COORD_KINDS 3
+#define COORD_MAX_CAPACITY 64
+#define COORD_LINE 64
+
+// A combining request slot, one per thread.
+typedef struct {
+    int op;                  // COORD_OP_BOARD or COORD_OP_UNBOARD
+    int arg;                 // Seat to free
+    int result;              // Seat taken, -1 when the ferry was full
+    int pending;             // Set by the car, cleared by the combiner
+    char pad[COORD_LINE - 4 * sizeof(int)];
+} coord_slot_t;
+
+typedef struct {
+    coord_kind_t kind;
+    int capacity;
+    int threads;
+    int load;                // Cars aboard
+    char pad0[COORD_LINE - 4 * sizeof(int)];
+    uint64_t seats;          // Bit s set while seat s is taken
+    char pad1[COORD_LINE - sizeof(uint64_t)];
+    int combiner;            // Combining flag, 1 while a car combines
+    char pad2[COORD_LINE - sizeof(int)];
+    pthread_mutex_t lock;    // mutex kind
+    coord_slot_t *slots;     // combining kind, `threads` slots
+    void *block;
+    unsigned long passes;    // Scans that served a request (written by the combiner)
+    unsigned long combined;  // Requests applied in them
+} board_coord_t;
+
+const char *coord_kind_name(coord_kind_t kind);
+int coord_kind_parse(const char *name);  // -1 when unknown
+
+// threads is the number of distinct callers; each passes its own index
+// 0 .. threads - 1. Returns -1 when out of memory or capacity is too big.
+int coord_init(board_coord_t *c, coord_kind_t kind, int capacity, int threads);
+int coord_board(board_coord_t *c, int thread);   // Seat taken, -1 when full
+void coord_unboard(board_coord_t *c, int thread, int seat);
+void coord_destroy(board_coord_t *c);
+
+#endif
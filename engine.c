@@ -0,0 +1,85 @@
+#include <stddef.h>     // NULL
+#include "engine.h"
+
+// --- GENERIC ENGINE ---
+// Loops over the runtime capacity and scans the full-size seat bitmap.
+static void generic_release_all(sync_sem_t *sem, int capacity) {
+    for (int i = 0; i < capacity; i++) {
+        sync_post(sem);
+    }
+}
+
+static int generic_claim_seat(uint64_t *seats, int capacity) {
+    int words = (capacity + 63) / 64;
+    for (int w = 0; w < words; w++) {
+        uint64_t free_bits = ~seats[w];
+        if (free_bits == 0) continue;
+
+        int seat = w * 64 + __builtin_ctzll(free_bits);
+        if (seat >= capacity) return -1;
+        seats[w] |= 1ULL << (seat % 64);
+        return seat;
+    }
+    return -1;
+}
+
+static void seat_clear(uint64_t *seats, int seat) {
+    seats[seat / 64] &= ~(1ULL << (seat % 64));
+}
+
+static const ferry_engine_t generic_engine = {
+    "generic", 0, generic_release_all, generic_claim_seat, seat_clear
+};
+
+// --- SPECIALIZED ENGINES ---
+// DEFINE_FERRY_ENGINE(N) instantiates an engine for capacity N. The trip
+// counts are compile-time constants, so the release loop is fully
+// unrolled and the seat scan only visits the (N + 63) / 64 words in use.
+#define DEFINE_FERRY_ENGINE(N)                                              \
+    static void release_all_##N(sync_sem_t *sem, int capacity) {            \
+        (void)capacity;                                                     \
+        _Pragma("GCC unroll 64")                                            \
+        for (int i = 0; i < (N); i++) {                                     \
+            sync_post(sem);                                                 \
+        }                                                                   \
+    }                                                                       \
+                                                                            \
+    static int claim_seat_##N(uint64_t *seats, int capacity) {              \
+        (void)capacity;                                                     \
+        _Pragma("GCC unroll 4")                                             \
+        for (int w = 0; w < ((N) + 63) / 64; w++) {                         \
+            /* Bits past N in the last word always read as occupied. */     \
+            uint64_t valid = (w == (N) / 64) ? (1ULL << ((N) % 64)) - 1     \
+                                             : ~0ULL;                       \
+            uint64_t free_bits = ~seats[w] & valid;                         \
+            if (free_bits == 0) continue;                                   \
+            int bit = __builtin_ctzll(free_bits);                           \
+            seats[w] |= 1ULL << bit;                                        \
+            return w * 64 + bit;                                            \
+        }                                                                   \
+        return -1;                                                          \
+    }                                                                       \
+                                                                            \
+    static const ferry_engine_t engine_##N = {                              \
+        "fixed-" #N, (N), release_all_##N, claim_seat_##N, seat_clear       \
+    };
+
+DEFINE_FERRY_ENGINE(5)
+DEFINE_FERRY_ENGINE(10)
+DEFINE_FERRY_ENGINE(20)
+DEFINE_FERRY_ENGINE(50)
+
+// --- DISPATCH ---
+static const ferry_engine_t *const specialized_engines[] = {
+    &engine_5, &engine_10, &engine_20, &engine_50
+};
+
+const ferry_engine_t *select_engine(int capacity, bool force_generic) {
+    if (!force_generic) {
+        int count = sizeof(specialized_engines) / sizeof(specialized_engines[0]);
+        for (int i = 0; i < count; i++) {
+            if (specialized_engines[i]->capacity == capacity) return specialized_engines[i];
+        }
+    }
+    return &generic_engine;
+}
@@ -0,0 +1,39 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>    // Boolean Type
+#include <stdint.h>     // uint64_t
+#include "sync.h"       // sync_sem_t, the permit semaphores
+
+// --- ENGINE LIMITS ---
+#define MAX_CAPACITY 1024                   // Largest supported ferry capacity
+#define SEAT_WORDS ((MAX_CAPACITY + 63) / 64) // Words in the generic seat bitmap
+
+// --- FERRY ENGINE ---
+// The capacity-dependent steps of a ferry cycle. The common capacities
+// (5, 10, 20, 50) get variants generated at compile time with unrolled
+// loops and fixed-size seat bitmaps; any other capacity uses the generic
+// engine, which loops over the runtime capacity.
+//
+// Every operation takes the capacity so all engines share one signature;
+// the specialized variants ignore it in favour of their built-in constant.
+typedef struct {
+    const char *name;       // Shown in logs and benchmark output
+    int capacity;           // Built-in capacity, 0 for the generic engine
+
+    // Posts one permit per seat (boarding or unboarding release).
+    void (*release_all)(sync_sem_t *sem, int capacity);
+
+    // Marks the lowest free seat as occupied and returns its index,
+    // or -1 when the ferry is full. Callers serialize seat updates.
+    int (*claim_seat)(uint64_t *seats, int capacity);
+
+    // Marks a seat as free again.
+    void (*free_seat)(uint64_t *seats, int seat);
+} ferry_engine_t;
+
+// Picks the specialized engine for a capacity, or the generic one when
+// there is none (or when force_generic is set, for benchmarking).
+const ferry_engine_t *select_engine(int capacity, bool force_generic);
+
+#endif
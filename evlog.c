@@ -0,0 +1,537 @@
+#define _GNU_SOURCE     // clock_gettime under -std=c99
+
+#include <stdlib.h>     // malloc, free
+#include <string.h>     // memcpy, memcmp
+#include <stdbool.h>    // Boolean Type
+#include <pthread.h>    // Compressor thread
+#include <time.h>       // Compression timing
+#include <fcntl.h>      // open
+#include <unistd.h>     // write, close
+#include <errno.h>      // EINTR
+#include "evlog.h"
+#include "pool.h"       // Block buffers are reserved through large_alloc
+
+const char *event_type_name(int type) {
+    switch (type) {
+    case EV_FERRY_ARRIVE: return "arrive";
+    case EV_FERRY_DEPART: return "depart";
+    case EV_CAR_BOARD:    return "board";
+    case EV_CAR_UNBOARD:  return "unboard";
+    default:              return "unknown";
+    }
+}
+
+// --- BYTE ENCODING ---
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static size_t put_varint(uint8_t *p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Returns the number of bytes consumed, or 0 when the varint is truncated.
+static size_t get_varint(const uint8_t *p, size_t avail, uint64_t *v) {
+    *v = 0;
+    for (size_t n = 0; n < avail && n < 10; n++) {
+        *v |= (uint64_t)(p[n] & 0x7f) << (7 * n);
+        if ((p[n] & 0x80) == 0) return n + 1;
+    }
+    return 0;
+}
+
+static void encode_header(uint8_t *h, const evlog_block_t *b) {
+    put_u32(h, EVLOG_BLOCK_MAGIC);
+    put_u32(h + 4, b->flags);
+    put_u32(h + 8, b->raw_len);
+    put_u32(h + 12, b->payload_len);
+    put_u32(h + 16, b->event_count);
+    put_u32(h + 20, 0);
+    put_u64(h + 24, (uint64_t)b->first_us);
+    put_u64(h + 32, (uint64_t)b->last_us);
+}
+
+// --- LZ CODEC ---
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 65535
+
+size_t lz_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+static uint32_t lz_hash(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Emits a length remainder as a run of 255s and a final byte.
+static uint8_t *lz_put_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static uint8_t *lz_put_sequence(uint8_t *op, const uint8_t *lit, size_t lit_len,
+                                size_t offset, size_t match_len) {
+    uint8_t *token = op++;
+    *token = (uint8_t)((lit_len < 15 ? lit_len : 15) << 4);
+    if (lit_len >= 15) op = lz_put_length(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (match_len == 0) return op; // Final literal-only sequence
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t extra = match_len - LZ_MIN_MATCH;
+    *token |= (uint8_t)(extra < 15 ? extra : 15);
+    if (extra >= 15) op = lz_put_length(op, extra - 15);
+    return op;
+}
+
+size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    if (cap < lz_bound(len)) return 0;
+
+    uint32_t table[1 << LZ_HASH_BITS];
+    memset(table, 0xff, sizeof(table));
+
+    const uint8_t *ip = src, *anchor = src, *end = src + len;
+    uint8_t *op = dst;
+
+    while (ip + LZ_MIN_MATCH <= end) {
+        uint32_t h = lz_hash(ip);
+        uint32_t cand = table[h];
+        table[h] = (uint32_t)(ip - src);
+
+        if (cand != 0xffffffffu && (size_t)(ip - src) - cand <= LZ_MAX_OFFSET &&
+            memcmp(src + cand, ip, LZ_MIN_MATCH) == 0) {
+            const uint8_t *match = src + cand;
+            size_t mlen = LZ_MIN_MATCH;
+            while (ip + mlen < end && match[mlen] == ip[mlen]) mlen++;
+
+            op = lz_put_sequence(op, anchor, ip - anchor, ip - match, mlen);
+            ip += mlen;
+            anchor = ip;
+        } else {
+            ip++;
+        }
+    }
+
+    op = lz_put_sequence(op, anchor, end - anchor, 0, 0);
+    return (size_t)(op - dst);
+}
+
+long lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    const uint8_t *ip = src, *end = src + len;
+    uint8_t *op = dst, *oend = dst + cap;
+
+    while (ip < end) {
+        uint8_t token = *ip++;
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= end) return -1;
+                b = *ip++;
+                lit_len += b;
+            } while (b == 255);
+        }
+        if ((size_t)(end - ip) < lit_len || (size_t)(oend - op) < lit_len) return -1;
+        memcpy(op, ip, lit_len);
+        op += lit_len;
+        ip += lit_len;
+        if (ip == end) break; // Final sequence has no match
+
+        if (end - ip < 2) return -1;
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        size_t match_len = (token & 15);
+        if (match_len == 15) {
+            uint8_t b;
+            do {
+                if (ip >= end) return -1;
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        match_len += LZ_MIN_MATCH;
+
+        if (offset == 0 || offset > (size_t)(op - dst) || (size_t)(oend - op) < match_len) return -1;
+        const uint8_t *match = op - offset;
+        for (size_t i = 0; i < match_len; i++) op[i] = match[i]; // May overlap
+        op += match_len;
+    }
+    return (long)(op - dst);
+}
+
+// --- WRITER ---
+#define EVLOG_QUEUE 4   // Raw blocks in flight between producers and compressor
+
+typedef struct {
+    uint8_t data[EVLOG_BLOCK_SIZE];
+    size_t used;
+    uint32_t count;
+    int64_t first_us;
+    int64_t last_us;
+    bool full;          // Waiting for (or being handled by) the compressor
+} raw_block_t;
+
+static raw_block_t *raw_blocks = NULL;
+static size_t raw_blocks_mapped = 0;
+static int fill_index = 0;          // Block producers append to
+static int compress_index = 0;      // Next block the compressor takes
+static bool closing = false;
+static int out_fd = -1;
+static int index_fd = -1;
+static uint8_t *out_block = NULL;   // Compressor output: header + payload
+static evlog_stats_t stats;
+
+static pthread_mutex_t evlog_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t block_full = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t block_free = PTHREAD_COND_INITIALIZER;
+static pthread_t compressor_tid;
+
+static void write_all(int fd, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+static void *compressor_thread(void *arg) {
+    (void)arg;
+    uint8_t *out = out_block;
+
+    pthread_mutex_lock(&evlog_lock);
+    while (true) {
+        raw_block_t *raw = &raw_blocks[compress_index];
+        if (!raw->full) {
+            if (closing) break;
+            pthread_cond_wait(&block_full, &evlog_lock);
+            continue;
+        }
+        pthread_mutex_unlock(&evlog_lock);
+
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        evlog_block_t b = { 0, (uint32_t)raw->used, 0, raw->count, raw->first_us, raw->last_us };
+        size_t clen = lz_compress(raw->data, raw->used, out + EVLOG_HEADER_SIZE,
+                                  lz_bound(EVLOG_BLOCK_SIZE));
+        if (clen == 0 || clen >= raw->used) {
+            b.flags = EVLOG_FLAG_STORED;
+            memcpy(out + EVLOG_HEADER_SIZE, raw->data, raw->used);
+            clen = raw->used;
+        }
+        b.payload_len = (uint32_t)clen;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        encode_header(out, &b);
+        write_all(out_fd, out, EVLOG_HEADER_SIZE + clen);
+
+        // Index entry for the block just written; stats.file_bytes is
+        // only updated by this thread, so it is the block's offset.
+        uint8_t entry[EVLOG_INDEX_ENTRY_SIZE];
+        put_u64(entry, (uint64_t)b.first_us);
+        put_u64(entry + 8, (uint64_t)b.last_us);
+        put_u64(entry + 16, stats.file_bytes);
+        write_all(index_fd, entry, sizeof(entry));
+
+        pthread_mutex_lock(&evlog_lock);
+        stats.compress_seconds += (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        stats.blocks++;
+        stats.raw_bytes += raw->used;
+        stats.file_bytes += EVLOG_HEADER_SIZE + clen;
+        raw->used = 0;
+        raw->count = 0;
+        raw->full = false;
+        compress_index = (compress_index + 1) % EVLOG_QUEUE;
+        pthread_cond_broadcast(&block_free);
+    }
+    pthread_mutex_unlock(&evlog_lock);
+    return NULL;
+}
+
+// Builds PATH.idx into buf. Returns false when it does not fit.
+static bool index_path(const char *path, char *buf, size_t size) {
+    size_t len = strlen(path);
+    if (len + sizeof(EVLOG_INDEX_SUFFIX) > size) return false;
+    memcpy(buf, path, len);
+    memcpy(buf + len, EVLOG_INDEX_SUFFIX, sizeof(EVLOG_INDEX_SUFFIX));
+    return true;
+}
+
+int evlog_open(const char *path) {
+    char idx_path[4096];
+    if (!index_path(path, idx_path, sizeof(idx_path))) return -1;
+    out_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) return -1;
+    index_fd = open(idx_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (index_fd < 0) return -1;
+
+    raw_blocks = large_alloc(sizeof(raw_block_t) * EVLOG_QUEUE, &raw_blocks_mapped);
+    out_block = counted_malloc(EVLOG_HEADER_SIZE + lz_bound(EVLOG_BLOCK_SIZE));
+    if (raw_blocks == NULL || out_block == NULL) return -1;
+    for (int i = 0; i < EVLOG_QUEUE; i++) {
+        raw_blocks[i].used = 0;
+        raw_blocks[i].count = 0;
+        raw_blocks[i].full = false;
+    }
+    fill_index = 0;
+    compress_index = 0;
+    closing = false;
+    memset(&stats, 0, sizeof(stats));
+
+    write_all(out_fd, EVLOG_FILE_MAGIC, 8);
+    write_all(index_fd, EVLOG_INDEX_MAGIC, 8);
+    stats.file_bytes = 8;
+    return pthread_create(&compressor_tid, NULL, compressor_thread, NULL) == 0 ? 0 : -1;
+}
+
+// Passes the fill block to the compressor and moves to the next one.
+// Called with evlog_lock held.
+static void hand_off_block(void) {
+    raw_blocks[fill_index].full = true;
+    pthread_cond_signal(&block_full);
+    fill_index = (fill_index + 1) % EVLOG_QUEUE;
+    while (raw_blocks[fill_index].full) {
+        pthread_cond_wait(&block_free, &evlog_lock);
+    }
+}
+
+void evlog_record(double time_sec, int type, int car_id) {
+    if (out_fd < 0) return;
+    int64_t t = (int64_t)(time_sec * 1e6 + 0.5);
+
+    pthread_mutex_lock(&evlog_lock);
+    raw_block_t *raw = &raw_blocks[fill_index];
+    if (raw->used + EVLOG_MAX_RECORD > EVLOG_BLOCK_SIZE) {
+        hand_off_block();
+        raw = &raw_blocks[fill_index];
+    }
+    if (raw->count == 0) {
+        raw->first_us = t;
+        raw->last_us = t;
+    }
+
+    uint8_t *p = raw->data + raw->used;
+    size_t n = put_varint(p, zigzag(t - raw->last_us));
+    p[n++] = (uint8_t)type;
+    n += put_varint(p + n, zigzag(car_id));
+    raw->used += n;
+    raw->count++;
+    raw->last_us = t;
+    stats.events++;
+    pthread_mutex_unlock(&evlog_lock);
+}
+
+void evlog_close(evlog_stats_t *out_stats) {
+    if (out_fd < 0) return;
+
+    pthread_mutex_lock(&evlog_lock);
+    if (raw_blocks[fill_index].used > 0) {
+        raw_blocks[fill_index].full = true;
+    }
+    closing = true;
+    pthread_cond_signal(&block_full);
+    pthread_mutex_unlock(&evlog_lock);
+    pthread_join(compressor_tid, NULL);
+
+    close(out_fd);
+    close(index_fd);
+    out_fd = -1;
+    index_fd = -1;
+    large_free(raw_blocks, raw_blocks_mapped);
+    counted_free(out_block);
+    raw_blocks = NULL;
+    out_block = NULL;
+    if (out_stats != NULL) *out_stats = stats;
+}
+
+// --- READER ---
+int evlog_reader_open(evlog_reader_t *r, const char *path) {
+    memset(r, 0, sizeof(*r));
+    r->file = fopen(path, "rb");
+    if (r->file == NULL) return -1;
+
+    char magic[8];
+    r->raw = malloc(EVLOG_BLOCK_SIZE);
+    r->payload = malloc(lz_bound(EVLOG_BLOCK_SIZE));
+    if (r->raw == NULL || r->payload == NULL ||
+        fread(magic, 1, 8, r->file) != 8 || memcmp(magic, EVLOG_FILE_MAGIC, 8) != 0) {
+        evlog_reader_close(r);
+        return -1;
+    }
+    return 0;
+}
+
+void evlog_reader_close(evlog_reader_t *r) {
+    if (r->file != NULL) fclose(r->file);
+    free(r->raw);
+    free(r->payload);
+    memset(r, 0, sizeof(*r));
+}
+
+// Reads the next block header. Returns 1, 0 at EOF, -1 if corrupt.
+static int read_header(evlog_reader_t *r) {
+    uint8_t h[EVLOG_HEADER_SIZE];
+    size_t got = fread(h, 1, sizeof(h), r->file);
+    if (got == 0) return 0;
+    if (got != sizeof(h) || get_u32(h) != EVLOG_BLOCK_MAGIC) return -1;
+
+    evlog_block_t *b = &r->block;
+    b->flags = get_u32(h + 4);
+    b->raw_len = get_u32(h + 8);
+    b->payload_len = get_u32(h + 12);
+    b->event_count = get_u32(h + 16);
+    b->first_us = (int64_t)get_u64(h + 24);
+    b->last_us = (int64_t)get_u64(h + 32);
+    if (b->raw_len > EVLOG_BLOCK_SIZE || b->payload_len > lz_bound(EVLOG_BLOCK_SIZE)) return -1;
+    return 1;
+}
+
+// Loads and decompresses the next block. Returns 1, 0 at EOF, -1 if corrupt.
+static int load_block(evlog_reader_t *r) {
+    int rc = read_header(r);
+    if (rc <= 0) return rc;
+
+    evlog_block_t *b = &r->block;
+    if (fread(r->payload, 1, b->payload_len, r->file) != b->payload_len) return -1;
+
+    if (b->flags & EVLOG_FLAG_STORED) {
+        if (b->payload_len != b->raw_len) return -1;
+        memcpy(r->raw, r->payload, b->raw_len);
+    } else if (lz_decompress(r->payload, b->payload_len, r->raw, EVLOG_BLOCK_SIZE) != (long)b->raw_len) {
+        return -1;
+    }
+
+    r->pos = 0;
+    r->remaining = b->event_count;
+    r->last_us = b->first_us;
+    return 1;
+}
+
+int evlog_reader_next(evlog_reader_t *r, evlog_event_t *ev) {
+    while (r->remaining == 0) {
+        int rc = load_block(r);
+        if (rc <= 0) return rc;
+    }
+
+    const uint8_t *p = r->raw + r->pos;
+    size_t avail = r->block.raw_len - r->pos;
+    uint64_t dt, car;
+    size_t n = get_varint(p, avail, &dt);
+    if (n == 0 || n >= avail) return -1;
+    int type = p[n++];
+    size_t m = get_varint(p + n, avail - n, &car);
+    if (m == 0) return -1;
+
+    r->pos += n + m;
+    r->remaining--;
+    r->last_us += unzigzag(dt);
+    ev->time_us = r->last_us;
+    ev->type = type;
+    ev->car_id = (int)unzigzag(car);
+    return 1;
+}
+
+// --- TIME INDEX ---
+int evlog_reader_seek_time(evlog_reader_t *r, int64_t from_us,
+                           const evlog_index_entry_t *index, size_t entries) {
+    r->remaining = 0;
+
+    if (index != NULL) {
+        // First block whose last event is not before from_us.
+        size_t lo = 0, hi = entries;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (index[mid].last_us < from_us) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo == entries) return fseek(r->file, 0, SEEK_END);
+        return fseek(r->file, (long)index[lo].offset, SEEK_SET);
+    }
+
+    // No index: hop from header to header until a block reaches from_us.
+    if (fseek(r->file, 8, SEEK_SET) != 0) return -1;
+    while (true) {
+        long offset = ftell(r->file);
+        int rc = read_header(r);
+        if (rc < 0) return -1;
+        if (rc == 0) return 0;
+        if (r->block.last_us >= from_us) return fseek(r->file, offset, SEEK_SET);
+        if (fseek(r->file, r->block.payload_len, SEEK_CUR) != 0) return -1;
+    }
+}
+
+long evlog_index_load(const char *path, evlog_index_entry_t **entries) {
+    char idx_path[4096];
+    *entries = NULL;
+    if (!index_path(path, idx_path, sizeof(idx_path))) return -1;
+
+    FILE *f = fopen(idx_path, "rb");
+    if (f == NULL) return -1;
+
+    char magic[8];
+    long count = -1;
+    if (fread(magic, 1, 8, f) == 8 && memcmp(magic, EVLOG_INDEX_MAGIC, 8) == 0 &&
+        fseek(f, 0, SEEK_END) == 0) {
+        long size = ftell(f) - 8;
+        count = size / EVLOG_INDEX_ENTRY_SIZE;
+        *entries = malloc(sizeof(evlog_index_entry_t) * (count > 0 ? count : 1));
+        if (*entries == NULL || fseek(f, 8, SEEK_SET) != 0) count = -1;
+        for (long i = 0; i < count; i++) {
+            uint8_t e[EVLOG_INDEX_ENTRY_SIZE];
+            if (fread(e, 1, sizeof(e), f) != sizeof(e)) { count = -1; break; }
+            (*entries)[i].first_us = (int64_t)get_u64(e);
+            (*entries)[i].last_us = (int64_t)get_u64(e + 8);
+            (*entries)[i].offset = (int64_t)get_u64(e + 16);
+        }
+    }
+    fclose(f);
+    if (count < 0) {
+        free(*entries);
+        *entries = NULL;
+    }
+    return count;
+}
@@ -0,0 +1,122 @@
+#ifndef EVLOG_H
+#define EVLOG_H
+
+#include <stddef.h>     // size_t
+#include <stdint.h>     // Fixed-width fields of the file format
+#include <stdio.h>      // FILE for the reader
+
+// --- EVENT TYPES ---
+// Kinds of events the simulation produces. The values are part of the
+// compressed log format, so new kinds go at the end.
+typedef enum {
+    EV_FERRY_ARRIVE,
+    EV_FERRY_DEPART,
+    EV_CAR_BOARD,
+    EV_CAR_UNBOARD
+} event_type_t;
+
+const char *event_type_name(int type);
+
+// --- COMPRESSED EVENT LOG FORMAT ---
+// File: "FERRYEV1", then blocks. Each block is a little-endian header
+// followed by its payload:
+//
+//   u32 magic ("FEVB")   u32 flags      u32 raw_len   u32 payload_len
+//   u32 event_count      u32 reserved   i64 first_us  i64 last_us
+//
+// The raw block is a sequence of records, each
+//   varint zigzag(time_us - previous time_us)   (first record: - first_us)
+//   u8     event type
+//   varint zigzag(car_id)                       (-1 for ferry events)
+// and the payload is the raw block compressed with the built-in LZ codec,
+// or stored as-is when EVLOG_FLAG_STORED is set.
+#define EVLOG_FILE_MAGIC "FERRYEV1"
+#define EVLOG_BLOCK_MAGIC 0x42564546u   // "FEVB"
+#define EVLOG_FLAG_STORED 1u
+#define EVLOG_BLOCK_SIZE (64 * 1024)    // Raw bytes per block (LZ offsets are 16-bit)
+#define EVLOG_HEADER_SIZE 40
+#define EVLOG_MAX_RECORD (10 + 1 + 5)   // Longest record: 64-bit delta varint, type, 32-bit car varint
+
+// --- TIME INDEX ---
+// Written next to the log as PATH.idx: "FERRYIX1", then one entry per
+// block (three little-endian i64: first_us, last_us, file offset of the
+// block header). Entries are in file order, and since events are logged
+// in time order they are sorted by time too, so a reader can binary
+// search the block holding a given simulated time and seek straight to it.
+#define EVLOG_INDEX_MAGIC "FERRYIX1"
+#define EVLOG_INDEX_SUFFIX ".idx"
+#define EVLOG_INDEX_ENTRY_SIZE 24
+
+typedef struct {
+    int64_t first_us;
+    int64_t last_us;
+    int64_t offset;
+} evlog_index_entry_t;
+
+typedef struct {
+    uint32_t flags;
+    uint32_t raw_len;
+    uint32_t payload_len;
+    uint32_t event_count;
+    int64_t first_us;
+    int64_t last_us;
+} evlog_block_t;
+
+typedef struct {
+    int64_t time_us;
+    int type;
+    int car_id;
+} evlog_event_t;
+
+// --- LZ CODEC ---
+// Byte-oriented LZ77 in the style of LZ4: sequences of literals followed
+// by a match (16-bit offset, length >= 4). No external dependency.
+size_t lz_bound(size_t len);
+size_t lz_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+long lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+// --- WRITER ---
+// Producers encode records into the current raw block; full blocks are
+// handed to a dedicated compressor thread, which compresses and writes
+// them, so compression never runs on a simulation thread.
+typedef struct {
+    uint64_t events;
+    uint64_t blocks;
+    uint64_t raw_bytes;
+    uint64_t file_bytes;
+    double compress_seconds;    // Time the compressor thread spent compressing
+} evlog_stats_t;
+
+int evlog_open(const char *path);     // Also creates PATH.idx
+void evlog_record(double time_sec, int type, int car_id);  // Thread-safe
+void evlog_close(evlog_stats_t *stats);
+
+// --- READER ---
+typedef struct {
+    FILE *file;
+    evlog_block_t block;        // Header of the block being decoded
+    uint8_t *raw;               // Decompressed block
+    uint8_t *payload;           // Compressed block as read from the file
+    size_t pos;                 // Decode position in raw
+    uint32_t remaining;         // Records left in the block
+    int64_t last_us;            // Time of the previous record
+} evlog_reader_t;
+
+int evlog_reader_open(evlog_reader_t *r, const char *path);
+void evlog_reader_close(evlog_reader_t *r);
+
+// Positions the reader at the first block that may hold events at or after
+// from_us. Uses the index when one is given (binary search and one seek),
+// otherwise walks the block headers without decompressing them.
+int evlog_reader_seek_time(evlog_reader_t *r, int64_t from_us,
+                           const evlog_index_entry_t *index, size_t entries);
+
+// Loads PATH.idx for the log at path. Returns the entry count, or -1 when
+// there is no usable index. The caller frees *entries.
+long evlog_index_load(const char *path, evlog_index_entry_t **entries);
+
+// Reads the next event. Returns 1 on success, 0 at end of file, -1 on a
+// corrupt file.
+int evlog_reader_next(evlog_reader_t *r, evlog_event_t *ev);
+
+#endif
@@ -0,0 +1,122 @@
+#define _GNU_SOURCE     // getopt_long under -std=c99
+
+#include <stdio.h>      // Standard Input/Output
+#include <stdlib.h>     // exit
+#include <stdbool.h>    // Boolean Type
+#include <getopt.h>     // Command-line options
+#include <stdint.h>     // INT64_MAX
+#include <time.h>       // Query timing
+#include "evlog.h"      // Compressed event log reader
+
+// --- FERRY LOG ANALYZER ---
+// Reads a compressed event log written with `ferry_cross --event-log` and
+// prints a summary, or the events themselves in the simulator's text format.
+// With --from/--to only the blocks overlapping that simulated-time window
+// are read, located through the PATH.idx time index when it exists.
+
+void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options] EVENT_LOG\n"
+            "  --events      print every event in the simulator's log format\n"
+            "  --from SEC    only consider events at or after SEC\n"
+            "  --to SEC      only consider events at or before SEC\n"
+            "  --no-index    ignore the .idx file and walk block headers instead\n",
+            prog);
+}
+
+void print_event(const evlog_event_t* ev) {
+    double t = ev->time_us / 1e6;
+    switch (ev->type) {
+    case EV_FERRY_ARRIVE: printf("[Clock : %.4f] Ferry arrives to new dock\n", t); break;
+    case EV_FERRY_DEPART: printf("[Clock : %.4f] Ferry leaves the dock\n", t); break;
+    case EV_CAR_BOARD:    printf("[Clock : %.4f] Car %d entered the ferry\n", t, ev->car_id); break;
+    case EV_CAR_UNBOARD:  printf("[Clock : %.4f] Car %d left the ferry\n", t, ev->car_id); break;
+    default:              printf("[Clock : %.4f] unknown event %d\n", t, ev->type); break;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    static const struct option options[] = {
+        { "events", no_argument, NULL, 'e' },
+        { "from",   required_argument, NULL, 'f' },
+        { "to",     required_argument, NULL, 't' },
+        { "no-index", no_argument, NULL, 'n' },
+        { "help",   no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    bool print_events = false;
+    bool windowed = false;
+    bool use_index = true;
+    int64_t from_us = 0, to_us = INT64_MAX;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'e': print_events = true; break;
+        case 'f': from_us = (int64_t)(atof(optarg) * 1e6); windowed = true; break;
+        case 't': to_us = (int64_t)(atof(optarg) * 1e6); windowed = true; break;
+        case 'n': use_index = false; break;
+        case 'h': usage(argv[0]); exit(EXIT_SUCCESS);
+        default:  usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1) { usage(argv[0]); exit(EXIT_FAILURE); }
+
+    evlog_reader_t reader;
+    if (evlog_reader_open(&reader, argv[optind]) != 0) {
+        perror("Failed to open event log"); exit(EXIT_FAILURE);
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (windowed) {
+        evlog_index_entry_t* index = NULL;
+        long entries = use_index ? evlog_index_load(argv[optind], &index) : -1;
+        if (evlog_reader_seek_time(&reader, from_us, index,
+                                   entries < 0 ? 0 : (size_t)entries) != 0) {
+            fprintf(stderr, "Failed to seek in event log\n");
+            exit(EXIT_FAILURE);
+        }
+        free(index);
+    }
+
+    // Per-type counts plus the first/last timestamps.
+    unsigned long counts[EV_CAR_UNBOARD + 1] = { 0 };
+    unsigned long total = 0;
+    int64_t first_us = 0, last_us = 0;
+    int max_car = 0;
+
+    evlog_event_t ev;
+    int rc;
+    while ((rc = evlog_reader_next(&reader, &ev)) == 1) {
+        if (ev.time_us < from_us) continue;
+        if (ev.time_us > to_us) break;
+        if (total == 0) first_us = ev.time_us;
+        last_us = ev.time_us;
+        total++;
+        if (ev.type >= 0 && ev.type <= EV_CAR_UNBOARD) counts[ev.type]++;
+        if (ev.car_id > max_car) max_car = ev.car_id;
+        if (print_events) print_event(&ev);
+    }
+    evlog_reader_close(&reader);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (rc < 0) {
+        fprintf(stderr, "Corrupt event log after %lu events\n", total);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!print_events) {
+        printf("Events: %lu over %.4f s\n", total, (last_us - first_us) / 1e6);
+        for (int t = 0; t <= EV_CAR_UNBOARD; t++) {
+            printf("  %-8s %lu\n", event_type_name(t), counts[t]);
+        }
+        printf("Highest car id: %d\n", max_car);
+        if (counts[EV_FERRY_DEPART] > 0) {
+            printf("Average load per departure: %.2f cars\n",
+                   (double)counts[EV_CAR_BOARD] / counts[EV_FERRY_DEPART]);
+        }
+        printf("Read in %.3f ms\n",
+               (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+    }
+    return 0;
+}
@@ -1,33 +1,237 @@
+#define _GNU_SOURCE     // usleep and other POSIX/Linux extensions under -std=c99
+
 #include <stdio.h>      // Standard Input/Output
 #include <stdlib.h>     // General Utilities (malloc, rand, exit)
 #include <unistd.h>     // Sleep, Usleep for delays
 #include <pthread.h>    // Thread Operations
-#include <semaphore.h>  // Semaphores for synchronization
 #include <sys/time.h>   // High-precision time measurement
 #include <errno.h>      // Error Codes
 #include <stdbool.h>    // Boolean Type
 #include <time.h>       // Time Functions
 #include <fcntl.h>      // O_CREAT (Required for macOS sem_open compatibility)
+#include <getopt.h>     // Command-line options
+#include <string.h>     // strcmp
+#include <stdint.h>     // uint64_t
+#include <sched.h>      // sched_yield for injected yields
+#include <sys/mman.h>   // Shared dock segment (shm_open, mmap)
+#include <sys/wait.h>   // waitpid for car and shard processes
+#include <sys/socket.h> // socketpair links between shards and the coordinator
+#include <signal.h>     // SIGHUP parameter reload
+#ifdef __linux__
+#include <poll.h>                // Reload thread waits on the file watch
+#include <sys/inotify.h>         // Watch the --params file
+#include <sys/syscall.h>         // perf_event_open has no libc wrapper
+#include <linux/perf_event.h>    // Hardware cache counters (dTLB misses)
+#endif
+#include "pool.h"       // Fixed-size pools and per-cycle arenas
+#include "engine.h"     // Capacity-specialized ferry engines
+#include "sync.h"       // Semaphore backends (named, unnamed, condvar, futex, spin, eventfd)
+#include "log.h"        // Log output (stdio or per-thread buffers)
+#include "evlog.h"      // Compressed binary event log
+#include "results.h"    // Columnar per-run results store
+#include "timeline.h"   // Gantt interval export
+#include "shard.h"      // Shard messages and the coordinator
+#include "phase.h"      // Generation-based phase barriers (--cycle barrier)
+#include "params.h"     // Reloadable scenario parameters (--params)
+#include "scenario.h"   // Compiled scenario scripts (--scenario)
+#include "policy.h"     // Departure and boarding policies (--policy)
 
 // --- CONFIGURATION ---
 #define FERRY_CAPACITY 5   // Maximum number of cars the ferry can carry
 #define PROGRAM_RUNTIME 60 // Total duration of the simulation in seconds
+#define CYCLE_EVENT_SLACK 8   // Cycle event records reserved beyond two per seat
+#define BENCH_CYCLES 1000000  // Boarding/unboarding cycles per engine benchmark
+#define BENCH_LOG_BYTES (256L * 1024 * 1024) // Bytes written per sink benchmark
+#define BENCH_LOG_CALLS 100000000L // Log statements per log level benchmark case
+#define FERRY_PHASES (TL_UNBOARDING + 1) // Ferry phases, numbered as in the timeline
+#define TAIL_BUCKETS 32       // Power-of-two microsecond buckets of the last-car wait
+#define CHECK_TRACE_SIZE 4096 // Trace ring entries in heavy check mode (power of two)
+#define CHECK_EXCERPT 24      // Trace entries printed with the first violation
+#define CAR_STACK_SIZE (256 * 1024) // Car threads are shallow; lets thousands run
+#define STRESS_STALL_MS 5000  // Watchdog threshold in stress mode unless given
+#define WATCHDOG_POLL_US 100000 // Watchdog polling interval (also main's)
+#define CACHE_LINE 64         // Progress slots are padded to one line each
+#define DOCK_SHM_NAME "/ferry_dock" // Shared dock segment in process mode
+#define SHARD_SYNC_MS 250     // Time ping interval of a shard
+
+// How much invariant checking the simulation does.
+typedef enum {
+    CHECK_OFF,     // No checks (for overhead comparisons only)
+    CHECK_ON,      // Cheap checks on every boarding, unboarding and phase change
+    CHECK_HEAVY    // Also a cross-cycle trace ring and a seat bitmap recount
+} check_mode_t;
+
+// What the watchdog does when no agent made progress within the threshold.
+typedef enum {
+    STALL_REPORT,    // Dump the agents and semaphores, keep running
+    STALL_DEPART,    // Dump, then send a ferry waiting to fill off partially loaded
+    STALL_SHUTDOWN,  // Dump, then end the run and print the reports
+    STALL_ABORT      // Dump, then exit with a failure status (stress default)
+} stall_action_t;
+
+// Runtime settings. Defaults reproduce the original assignment.
+typedef struct {
+    int runtime_sec;          // Simulation length in seconds
+    int num_cars;             // Number of car threads
+    int capacity;             // Number of cars the ferry carries per trip
+    bool generic_engine;      // Skip the capacity-specialized engines
+    page_mode_t page_mode;    // Backing of the large pools and arenas
+    const char* bench;        // Benchmark to run instead of the simulation
+    log_mode_t log_mode;      // stdio or per-thread buffered output
+    int log_flush;            // Buffered flush policy (LOG_FLUSH_* or N lines)
+    sink_kind_t log_sink;     // Where buffered output is written
+    const char* log_file;     // Log file, NULL for stdout
+    const char* event_log;    // Compressed binary event log, NULL when off
+    const char* timeline;     // Phase and seat interval file, NULL when off
+    const char* results;      // Columnar results file to append this run to
+    const char* run_tag;      // Label stored with the run's results
+    int sample_one_in;        // Log 1 in N cars, chosen by id hash (1 = all)
+    int reservoir_size;       // Complete journeys kept for the final report
+    double tail_wait_sec;     // Only log journeys that waited longer (0 = off)
+    check_mode_t check_mode;  // Invariant checking level
+    sync_backend_t sync;      // Primitive behind the four permit semaphores
+    bool stress;              // No modeled delays, watchdog on
+    unsigned long max_cycles; // Stop after this many departures (0 = runtime only)
+    int chaos_percent;        // Chance of an injected yield or sleep per sync point
+    int watchdog_ms;          // Stall threshold, 0 = no watchdog
+    stall_action_t on_stall;  // What the watchdog does about a stall
+    int processes;            // Car processes, 0 = cars are threads of this process
+    int shards;               // Shard processes, each with its own dock (0 = off)
+    int transfer_percent;     // Chance a car drives on to another shard per journey
+    bool cycle_barrier;       // Full, unboard and empty handoffs through phase barriers
+    int barrier_fanin;        // Combining tree fan-in of the barriers (0 = one counter)
+    const char* params_file;  // Scenario parameters, watched and reloaded (NULL = defaults)
+    const char* scenario_file; // Scenario script compiled at startup (NULL = none)
+    const char* policy;       // Built-in policy name or plugin path
+    const char* policy_args;  // Passed to the policy's create callback
+} sim_config_t;
+
+sim_config_t config = {
+    PROGRAM_RUNTIME, FERRY_CAPACITY, FERRY_CAPACITY, false, PAGES_NORMAL, NULL,
+    LOG_STDIO, LOG_FLUSH_CYCLE, SINK_WRITE, NULL, NULL, NULL, NULL, "", 1, 0, 0.0, CHECK_ON,
+    SYNC_NAMED, false, 0, 0, 0, STALL_REPORT, 0, 0, 0, false, 0, NULL, NULL, "semaphore", ""
+};
+
+// Delays and departure policy the run starts with: the defaults, or the
+// --params file as read at startup. Later reloads go to dock->params.
+scenario_params_t startup_params;
+
+// --- SIMULATION RECORDS ---
+// Event kinds (event_type_t) are defined in evlog.h, as they are part of
+// the compressed log format.
+
+// One event of the current ferry cycle. Records live in the cycle arena and
+// are released together when the ferry starts boarding again.
+typedef struct sim_event {
+    double time;             // Relative time of the event in seconds
+    event_type_t type;       // What happened
+    int car_id;              // Car involved, -1 for ferry events
+    struct sim_event *next;  // Next event of the same cycle
+} sim_event_t;
+
+// Per-car state. Agents come from a fixed pool instead of individual mallocs.
+typedef struct {
+    int id;                  // Car number shown in the log (1..N)
+    int seat;                // Seat held on the ferry, -1 while ashore
+    bool sampled;            // Chosen by the 1-in-N id hash (fixed per car)
+    bool log_journey;        // Events of the current journey are logged
+    double queued_at;        // When the current journey started waiting
+    double boarded_at;       // When the car boarded on this journey
+    unsigned long boarded_departure; // Departures before this car boarded
+    unsigned int landed_seen;        // Landing generation when it boarded (--cycle barrier)
+} car_agent_t;
+
+// Where a car is in its journey, for watchdog dumps.
+typedef enum {
+    CAR_ASHORE,      // Driving around between journeys
+    CAR_QUEUED,      // Waiting for a boarding permit
+    CAR_ABOARD,      // Waiting for an unboarding permit
+    CAR_LEAVING      // Unboarding
+} car_phase_t;
+
+// One complete car journey: queue -> board -> unboard.
+typedef struct {
+    int car_id;
+    double queued_at;
+    double boarded_at;
+    double unboarded_at;
+} journey_t;
 
 // --- GLOBAL VARIABLES ---
-// Mutex to protect critical sections where shared variables are modified
-pthread_mutex_t car_count_mutex;
-
-// Named semaphore pointers. 
-//  use pointers and sem_open (instead of sem_init) to ensure compatibility 
-// with macOS, which does not support unnamed semaphores fully.
-sem_t *sem_board;    // Signals cars that they can board
-sem_t *sem_full;     // Signals the ferry that the boat is full
-sem_t *sem_unboard;  // Signals cars that they can unboard
-sem_t *sem_empty;    // Signals the ferry that the boat is empty
-
-int cars_on_board = 0;      // Shared counter for cars currently on the ferry
+// How the ferry's phase looks to the cars and the invariant checker.
+typedef enum { FERRY_BOARDING, FERRY_CROSSING, FERRY_UNBOARDING } ferry_state_t;
+
+// Dock state: everything the ferry and the cars both touch. In thread mode
+// it is ordinary memory; with --processes it lives in a shared memory
+// segment mapped before the car processes are forked, so every process
+// sees it at the same address and the cycle records can keep linking each
+// other by pointer. The permit semaphores and the mutex are then created
+// process-shared.
+typedef struct {
+    // Mutex to protect critical sections where shared variables are modified
+    pthread_mutex_t lock;
+
+    // Permit semaphores. The default backend is named semaphores (sem_open
+    // instead of sem_init) for compatibility with macOS, which does not
+    // support unnamed semaphores fully; --sync selects another backend.
+    sync_sem_t sem_board;    // Signals cars that they can board
+    sync_sem_t sem_full;     // Signals the ferry that the boat is full
+    sync_sem_t sem_unboard;  // Signals cars that they can unboard
+    sync_sem_t sem_empty;    // Signals the ferry that the boat is empty
+
+    // With --cycle barrier only sem_board is used: the cars aboard arrive
+    // at `boarded` and `emptied`, whose last arrival wakes the ferry, and
+    // the ferry releases `landed` to let every car aboard off at once.
+    phase_barrier_t boarded;
+    phase_barrier_t landed;
+    phase_barrier_t emptied;
+
+    // Current scenario parameters. The ferry and the cars copy them once
+    // per cycle or journey without locking; the reload thread swaps them.
+    params_domain_t params;
+
+    int cars_on_board;              // Shared counter for cars currently on the ferry
+    int cycle_capacity;             // Seats offered this cycle (a --scenario vessel may be smaller)
+    uint64_t seats[SEAT_WORDS];     // Occupancy bitmap, one bit per seat
+    int ferry_state;                // Read by the cars, written by the ferry
+
+    arena_t cycle_arena;            // Event records of the current ferry cycle
+    sim_event_t *cycle_events;      // Head of the current cycle's record list
+    sim_event_t *cycle_events_tail; // Tail, so records stay in time order
+    unsigned long events_logged;    // Total number of logged events
+    unsigned long departures;       // Crossings started by the ferry
+    double cycle_first_board;       // When the first car of this cycle boarded
+    double cycle_prev_board;        // When the previous car (or the permits) came
+    double cycle_last_car_wait;     // Gap before the car that filled the ferry
+
+    unsigned long check_boards;     // Lock-free boarding total
+    unsigned long check_unboards;   // Lock-free unboarding total
+    unsigned long check_violations;
+    int check_reported;             // Set once the first violation is printed
+    unsigned long check_trace_next; // Entries ever written to the ring
+
+    int ferry_done;                 // Set when the ferry thread has stopped
+    int stop_requested;             // Set by the watchdog to end the run early
+} dock_t;
+
+dock_t* dock = NULL;
+void* dock_block = NULL;    // Heap block or shared mapping holding the dock
+size_t dock_size = 0;       // Mapping length in process mode
+
+const ferry_engine_t* engine; // Capacity-dependent steps of the ferry cycle
 struct timeval start_time;  // Timestamp when the program started
 
+// Storage reserved once at startup and recycled while the simulation runs.
+pool_t car_pool;            // Car agents
+unsigned long cars_carried = 0;        // Cars that boarded a departing ferry
+int partial_requested = 0;             // Set by the watchdog to depart partially loaded
+
+// Car ids of this process and of the whole run. They differ in a shard,
+// which runs a slice of the ids and adopts others that transfer in.
+int first_car_id = 1;       // This process's cars are first_car_id .. + num_cars - 1
+int total_cars = 0;         // Ids 1 .. total_cars exist across every shard
+int shard_index = -1;       // This process's shard, -1 when not sharded
+
 // --- TIME FUNCTION ---
 // Calculates the relative time elapsed since the start of the program.
 // Returns the time in seconds with microsecond precision.
@@ -40,6 +244,29 @@ double get_relative_time_sec() {
     return elapsed_sec;
 }
 
+// --- PROGRESS TRACKING ---
+// One slot per agent (slot 0 is the ferry, slot N is car N), each on its
+// own cache line so agents publishing progress never share a line. An
+// agent stores its phase at every transition, and the time as well when
+// the watchdog runs; the watchdog reads the slots without locking. The
+// slots follow the dock state, so car processes publish to them too.
+typedef struct {
+    double last_progress;    // Relative time of the last phase change
+    int phase;               // car_phase_t, or ferry_state_t for the ferry
+    int started;             // Set once the car's thread runs
+    char pad[CACHE_LINE - sizeof(double) - 2 * sizeof(int)];
+} progress_slot_t;
+
+progress_slot_t* progress = NULL;      // total_cars + 1 slots, cache-line aligned
+
+void note_progress(int slot, int phase) {
+    __atomic_store_n(&progress[slot].phase, phase, __ATOMIC_RELAXED);
+    if (config.watchdog_ms > 0) {
+        double now = get_relative_time_sec();
+        __atomic_store(&progress[slot].last_progress, &now, __ATOMIC_RELAXED);
+    }
+}
+
 // --- LOGGING FUNCTION ---
 // Handles formatting and printing of simulation events.
 // Includes a strict timing filter to meet the assignment requirement.
@@ -50,162 +277,2181 @@ void print_status(const char* message, int car_num) {
     // If the simulation runs past the defined runtime (60s) due to cleanup operations, 
     // we suppress standard logs to ensure the output cuts off exactly as required.
     // (car_num -99 is reserved for special system messages if needed).
-    if (current_time > PROGRAM_RUNTIME && car_num != -99) {
+    if (current_time > config.runtime_sec && car_num != -99) {
         return; 
     }
 
-    if (car_num == -1 || car_num == -99) {
+    char line[128];
+    int len;
+    if ((car_num == -1 || car_num == -99) && shard_index >= 0) {
+        // Every shard has its own ferry
+        len = snprintf(line, sizeof(line), "[Clock : %.4f] Ferry %d %s\n", current_time, shard_index, message);
+    } else if (car_num == -1 || car_num == -99) {
         // Ferry or System message
-        printf("[Clock : %.4f] Ferry %s\n", current_time, message);
+        len = snprintf(line, sizeof(line), "[Clock : %.4f] Ferry %s\n", current_time, message);
     } else {
         // Car message
-        printf("[Clock : %.4f] Car %d %s\n", current_time, car_num, message);
+        len = snprintf(line, sizeof(line), "[Clock : %.4f] Car %d %s\n", current_time, car_num, message);
+    }
+    if (len >= (int)sizeof(line)) len = sizeof(line) - 1;
+    log_line(line, len);
+}
+
+// Logs a status line when its level is compiled in and enabled at runtime.
+#define LOG_STATUS(level, message, car_num) \
+    do { if (LOG_ENABLED(level)) print_status(message, car_num); } while (0)
+
+// End-of-run report lines, at LOG_SUMMARY. Shards report to the
+// coordinator, which prints one table for all of them.
+#define print_summary(...) \
+    do { if (LOG_ENABLED(LOG_SUMMARY) && shard_index < 0) printf(__VA_ARGS__); } while (0)
+
+// --- DOCK LOCK ---
+// The dock lock is taken with cancellation disabled. Logging, modeled
+// sleeps and the event log hand-off inside the critical sections are
+// cancellation points, and a thread cancelled at shutdown while holding
+// the mutex would leave every other thread blocked on it.
+void lock_dock() {
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    pthread_mutex_lock(&dock->lock);
+}
+
+void unlock_dock() {
+    pthread_mutex_unlock(&dock->lock);
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+}
+
+// --- SAMPLING ---
+// With a million cars a full log is useless, so car events can be sampled:
+// 1 in N cars by a hash of the id (deterministic across runs), only the
+// journeys that waited longer than a threshold (tail sampling), and a
+// reservoir of complete journeys reported at exit. The per-journey
+// decision is a flag on the agent, so unsampled cars only pay a branch.
+journey_t* reservoir = NULL;          // reservoir_size journeys (Algorithm R)
+unsigned long journeys_seen = 0;      // Journeys offered to the reservoir
+bool track_journeys = false;          // Queue and unboard timestamps needed
+
+// Integer mixer (the splitmix64 finalizer); spreads consecutive ids evenly.
+uint64_t hash_car_id(int car_id) {
+    uint64_t x = (uint64_t)car_id + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+bool car_in_sample(int car_id) {
+    return config.sample_one_in <= 1 || hash_car_id(car_id) % config.sample_one_in == 0;
+}
+
+// Offers a finished journey to the reservoir. Callers hold the dock lock.
+void offer_journey(const car_agent_t* agent, double unboarded_at) {
+    unsigned long seen = journeys_seen++;
+    unsigned long slot = seen;
+    if (seen >= (unsigned long)config.reservoir_size) {
+        slot = (unsigned long)rand() % (seen + 1);
+        if (slot >= (unsigned long)config.reservoir_size) return;
     }
+    journey_t* j = &reservoir[slot];
+    j->car_id = agent->id;
+    j->queued_at = agent->queued_at;
+    j->boarded_at = agent->boarded_at;
+    j->unboarded_at = unboarded_at;
+}
+
+// --- INVARIANT CHECKS ---
+// Safety properties every change to the synchronization must preserve:
+//   - never more than `capacity` cars aboard, never fewer than zero;
+//   - cars board only while the ferry is boarding and unboard only after it
+//     has arrived, having crossed exactly once since they boarded;
+//   - the boarding and unboarding totals, kept with lock-free atomics
+//     independently of cars_on_board, agree with it at every phase change.
+// Checks run at points where the simulation already holds the dock lock,
+// so they cost a few compares and two atomic increments per journey. The
+// first violation is reported with a trace excerpt: the current cycle's
+// records, or with --check heavy the last entries of a trace ring that
+// spans cycles. Later violations are only counted.
+typedef struct {
+    double time;
+    int type;                // event_type_t of the traced event
+    int car_id;
+    int on_board;            // cars_on_board after the event
+    int ferry_state;
+} trace_entry_t;
+
+trace_entry_t* check_trace = NULL;     // CHECK_TRACE_SIZE entries (heavy mode)
+
+const char* ferry_state_name(int state) {
+    switch (state) {
+    case FERRY_BOARDING:  return "boarding";
+    case FERRY_CROSSING:  return "crossing";
+    default:              return "unboarding";
+    }
+}
+
+void set_ferry_state(int state) {
+    __atomic_store_n(&dock->ferry_state, state, __ATOMIC_RELEASE);
+    note_progress(0, state);
+}
+
+void check_trace_record(int type, int car_id) {
+    unsigned long slot = __atomic_fetch_add(&dock->check_trace_next, 1, __ATOMIC_RELAXED);
+    trace_entry_t* e = &check_trace[slot & (CHECK_TRACE_SIZE - 1)];
+    e->time = get_relative_time_sec();
+    e->type = type;
+    e->car_id = car_id;
+    e->on_board = dock->cars_on_board;
+    e->ferry_state = __atomic_load_n(&dock->ferry_state, __ATOMIC_ACQUIRE);
+}
+
+void print_trace_excerpt() {
+    if (config.check_mode == CHECK_HEAVY) {
+        unsigned long end = __atomic_load_n(&dock->check_trace_next, __ATOMIC_RELAXED);
+        unsigned long begin = end > CHECK_EXCERPT ? end - CHECK_EXCERPT : 0;
+        fprintf(stderr, "  Last %lu trace entries:\n", end - begin);
+        for (unsigned long i = begin; i < end; i++) {
+            const trace_entry_t* e = &check_trace[i & (CHECK_TRACE_SIZE - 1)];
+            fprintf(stderr, "    [%.6f] %-7s car %-4d on board %-4d ferry %s\n", e->time,
+                    event_type_name(e->type), e->car_id, e->on_board,
+                    ferry_state_name(e->ferry_state));
+        }
+        return;
+    }
+    // The caller holds the dock lock, so the cycle list is stable.
+    unsigned long count = 0;
+    for (sim_event_t* ev = dock->cycle_events; ev != NULL; ev = ev->next) count++;
+    unsigned long skip = count > CHECK_EXCERPT ? count - CHECK_EXCERPT : 0;
+    fprintf(stderr, "  Current cycle (last %lu of %lu records):\n", count - skip, count);
+    for (sim_event_t* ev = dock->cycle_events; ev != NULL; ev = ev->next) {
+        if (skip > 0) { skip--; continue; }
+        fprintf(stderr, "    [%.6f] %-7s car %d\n", ev->time, event_type_name(ev->type), ev->car_id);
+    }
+}
+
+void check_failed(const char* invariant, int car_id) {
+    __atomic_fetch_add(&dock->check_violations, 1, __ATOMIC_RELAXED);
+    int expected = 0;
+    if (!__atomic_compare_exchange_n(&dock->check_reported, &expected, 1, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) return;
+    fprintf(stderr, "Invariant violated at %.6f: %s (car %d, %d on board, ferry %s, "
+            "%lu boarded, %lu unboarded)\n",
+            get_relative_time_sec(), invariant, car_id, dock->cars_on_board,
+            ferry_state_name(__atomic_load_n(&dock->ferry_state, __ATOMIC_ACQUIRE)),
+            __atomic_load_n(&dock->check_boards, __ATOMIC_RELAXED),
+            __atomic_load_n(&dock->check_unboards, __ATOMIC_RELAXED));
+    print_trace_excerpt();
+}
+
+// Checks an invariant unless checking is off. Callers hold the dock lock.
+#define CHECK(cond, car_id, invariant) \
+    do { if (config.check_mode != CHECK_OFF && !(cond)) check_failed(invariant, car_id); } while (0)
+
+int seats_taken() {
+    int taken = 0;
+    for (int w = 0; w < SEAT_WORDS; w++) taken += __builtin_popcountll(dock->seats[w]);
+    return taken;
+}
+
+// Per-car assertions, after the car took its seat.
+void check_boarding(const car_agent_t* agent) {
+    if (config.check_mode == CHECK_OFF) return;
+    int car = agent->id;
+    unsigned long boards = __atomic_add_fetch(&dock->check_boards, 1, __ATOMIC_RELAXED);
+    unsigned long aboard = boards - __atomic_load_n(&dock->check_unboards, __ATOMIC_RELAXED);
+    int state = __atomic_load_n(&dock->ferry_state, __ATOMIC_ACQUIRE);
+    CHECK(dock->cars_on_board <= dock->cycle_capacity, car, "more cars aboard than the capacity");
+    CHECK(aboard == (unsigned long)dock->cars_on_board, car, "atomic totals disagree with cars_on_board");
+    CHECK(state == FERRY_BOARDING, car, "boarded while the ferry was not boarding");
+    CHECK(agent->seat >= 0 && agent->seat < config.capacity, car, "seat outside the ferry");
+    if (config.check_mode == CHECK_HEAVY) {
+        CHECK(seats_taken() == dock->cars_on_board, car, "seat bitmap disagrees with cars_on_board");
+    }
+}
+
+// Per-car assertions, after the car gave its seat back.
+void check_unboarding(const car_agent_t* agent) {
+    if (config.check_mode == CHECK_OFF) return;
+    int car = agent->id;
+    unsigned long unboards = __atomic_add_fetch(&dock->check_unboards, 1, __ATOMIC_RELAXED);
+    unsigned long aboard = __atomic_load_n(&dock->check_boards, __ATOMIC_RELAXED) - unboards;
+    int state = __atomic_load_n(&dock->ferry_state, __ATOMIC_ACQUIRE);
+    CHECK(dock->cars_on_board >= 0, car, "fewer than zero cars aboard");
+    CHECK(aboard == (unsigned long)dock->cars_on_board, car, "atomic totals disagree with cars_on_board");
+    CHECK(state == FERRY_UNBOARDING, car, "unboarded before the ferry arrived");
+    CHECK(dock->departures == agent->boarded_departure + 1, car, "unboarded without exactly one crossing");
+    if (config.check_mode == CHECK_HEAVY) {
+        CHECK(seats_taken() == dock->cars_on_board, car, "seat bitmap disagrees with cars_on_board");
+    }
+}
+
+// Ferry-side assertions when it departs (full, unless the watchdog forced a
+// partial departure) and when it starts boarding (empty).
+unsigned long cars_in_flight() {
+    return __atomic_load_n(&dock->check_boards, __ATOMIC_RELAXED) -
+           __atomic_load_n(&dock->check_unboards, __ATOMIC_RELAXED);
+}
+
+void check_departure(int load) {
+    CHECK(dock->cars_on_board == load, -1, "departed with an unexpected load");
+    CHECK(cars_in_flight() == (unsigned long)load, -1, "atomic totals disagree at departure");
+}
+
+void check_empty() {
+    CHECK(dock->cars_on_board == 0, -1, "boarding started on a non-empty ferry");
+    CHECK(cars_in_flight() == 0, -1, "atomic totals disagree at boarding");
+}
+
+// --- EVENT RECORDING ---
+// Appends an event to the current cycle. Callers must hold the dock lock.
+// Unlogged car events still feed the cycle records, just not the event log.
+void record_event(event_type_t type, int car_id, bool logged) {
+    sim_event_t *ev = arena_alloc(&dock->cycle_arena, sizeof(sim_event_t));
+    if (ev == NULL) return;
+
+    ev->time = get_relative_time_sec();
+    ev->type = type;
+    ev->car_id = car_id;
+    ev->next = NULL;
+
+    if (dock->cycle_events_tail != NULL) dock->cycle_events_tail->next = ev;
+    else dock->cycle_events = ev;
+    dock->cycle_events_tail = ev;
+    dock->events_logged++;
+    if (config.check_mode == CHECK_HEAVY) check_trace_record(type, car_id);
+
+    // Records are appended in time order because the caller holds the mutex.
+    if (config.event_log != NULL && logged) evlog_record(ev->time, type, car_id);
+}
+
+// Recycles every record of the finished cycle at once.
+void reset_cycle_events() {
+    lock_dock();
+    check_empty();
+    arena_reset(&dock->cycle_arena);
+    dock->cycle_events = NULL;
+    dock->cycle_events_tail = NULL;
+    unlock_dock();
+}
+
+// --- STRESS MODE ---
+// --stress removes every modeled delay (boarding, crossing, unboarding,
+// driving around) so the protocol runs as fast as the sync backend allows,
+// and --chaos injects random yields and short sleeps at the sync points to
+// shake out orderings normal runs never reach. The invariant checker
+// validates each cycle; a watchdog thread turns a deadlock into a report
+// of every agent's phase instead of a silent hang.
+__thread unsigned int chaos_seed;      // Per-thread, so chaos does not serialize on rand()
+
+// Sleeps for a modeled delay of min_us plus up to spread_us, unless stressed.
+void model_delay(long min_us, long spread_us) {
+    if (config.stress) return;
+    long us = min_us + (spread_us > 0 ? rand() % spread_us : 0);
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// Maybe perturbs the schedule. Sleeping is only allowed outside the
+// mutex: a sleep is a cancellation point, and a car cancelled while
+// holding the dock lock would block every other car at shutdown.
+void chaos_point(bool may_sleep) {
+    if (config.chaos_percent == 0) return;
+    int roll = rand_r(&chaos_seed) % 100;
+    if (roll >= config.chaos_percent) return;
+    if (may_sleep && (roll & 1)) usleep(1 + rand_r(&chaos_seed) % 100);
+    else sched_yield();
+}
+
+// --- WATCHDOG ---
+// Watches the progress slots. When no agent changed phase for watchdog_ms
+// (for example a ferry waiting on sem_full with fewer cars than seats), it
+// dumps every agent's phase and the semaphore values, then applies
+// --on-stall. The threshold must exceed the longest modeled phase (the
+// 3 s crossing) unless --stress removed the delays. Car slots are found
+// by id, so the cars may run in this process or in car processes.
+
+const char* car_phase_name(int phase) {
+    switch (phase) {
+    case CAR_QUEUED:  return "queued";
+    case CAR_ABOARD:  return "aboard";
+    case CAR_LEAVING: return "leaving";
+    default:          return "ashore";
+    }
+}
+
+const char* stall_action_name(int action) {
+    switch (action) {
+    case STALL_DEPART:   return "depart";
+    case STALL_SHUTDOWN: return "shutdown";
+    case STALL_ABORT:    return "abort";
+    default:             return "report";
+    }
+}
+
+double progress_time(int slot) {
+    double t;
+    __atomic_load(&progress[slot].last_progress, &t, __ATOMIC_RELAXED);
+    return t;
+}
+
+// Prints every agent's phase and how long it has been in it.
+void dump_agents(double now) {
+    int counts[CAR_LEAVING + 1] = { 0 };
+    int started = 0;
+    fprintf(stderr, "  Ferry: %s for %.3f s, %d on board, %lu departures\n",
+            ferry_state_name(__atomic_load_n(&progress[0].phase, __ATOMIC_RELAXED)),
+            now - progress_time(0), __atomic_load_n(&dock->cars_on_board, __ATOMIC_RELAXED),
+            __atomic_load_n(&dock->departures, __ATOMIC_RELAXED));
+    fprintf(stderr, "  Semaphores: board %d, full %d, unboard %d, empty %d\n",
+            sync_value(&dock->sem_board), sync_value(&dock->sem_full),
+            sync_value(&dock->sem_unboard), sync_value(&dock->sem_empty));
+    if (config.cycle_barrier) {
+        fprintf(stderr, "  Barriers: boarded gen %u, landed gen %u, emptied gen %u\n",
+                phase_generation(&dock->boarded), phase_generation(&dock->landed),
+                phase_generation(&dock->emptied));
+    }
+    for (int id = 1; id <= total_cars; id++) {
+        if (!__atomic_load_n(&progress[id].started, __ATOMIC_ACQUIRE)) continue;
+        int phase = __atomic_load_n(&progress[id].phase, __ATOMIC_RELAXED);
+        counts[phase]++;
+        fprintf(stderr, "%sCar %d: %s %.3f s%s", started % 6 == 0 ? "  " : " ", id,
+                car_phase_name(phase), now - progress_time(id), started % 6 == 5 ? "\n" : ",");
+        started++;
+    }
+    if (started % 6 != 0) fprintf(stderr, "\n");
+    fprintf(stderr, "  %d cars: %d ashore, %d queued, %d aboard, %d leaving\n", started,
+            counts[CAR_ASHORE], counts[CAR_QUEUED], counts[CAR_ABOARD], counts[CAR_LEAVING]);
+}
+
+// Asks a ferry waiting to fill up to leave with the cars it has. The post
+// happens under the dock lock only while the ferry is short of cars, so
+// the last car's own sem_full post can follow it but never precede it;
+// settle_partial_boarding() consumes that extra permit. The watchdog
+// passes a negative wait and may send the ferry off empty; the departure
+// policy passes how long the first car aboard must have waited.
+// The caller holds the dock lock.
+bool request_partial_departure(double first_car_waited) {
+    if (__atomic_load_n(&dock->ferry_state, __ATOMIC_ACQUIRE) == FERRY_BOARDING &&
+        dock->cars_on_board < dock->cycle_capacity &&
+        !__atomic_load_n(&partial_requested, __ATOMIC_ACQUIRE) &&
+        (first_car_waited < 0 ||
+         (dock->cycle_first_board >= 0 &&
+          get_relative_time_sec() - dock->cycle_first_board >= first_car_waited))) {
+        __atomic_store_n(&partial_requested, 1, __ATOMIC_RELEASE);
+        sync_post(&dock->sem_full);
+        return true;
+    }
+    return false;
+}
+
+bool force_partial_departure(double first_car_waited) {
+    lock_dock();
+    bool forced = request_partial_departure(first_car_waited);
+    unlock_dock();
+    return forced;
+}
+
+void* watchdog_thread(void* arg) {
+    (void)arg;
+    double threshold = config.watchdog_ms / 1000.0;
+    bool reported = false;       // One report per stall
+    while (!__atomic_load_n(&dock->ferry_done, __ATOMIC_ACQUIRE)) {
+        usleep(WATCHDOG_POLL_US);
+        double now = get_relative_time_sec();
+        double latest = progress_time(0);
+        for (int id = 1; id <= total_cars; id++) {
+            double t = progress_time(id);
+            if (t > latest) latest = t;
+        }
+        if (now - latest <= threshold) {
+            reported = false;
+            continue;
+        }
+        if (reported) continue;
+        reported = true;
+
+        fprintf(stderr, "Stall: no progress for %.3f s (%s backend), action %s\n",
+                now - latest, sync_backend_name(config.sync), stall_action_name(config.on_stall));
+        dump_agents(now);
+        switch (config.on_stall) {
+        case STALL_DEPART:
+            if (force_partial_departure(-1)) {
+                fprintf(stderr, "  Forcing a partial departure\n");
+            } else {
+                fprintf(stderr, "  The ferry is not waiting to fill up; nothing to force\n");
+            }
+            break;
+        case STALL_SHUTDOWN:
+            __atomic_store_n(&dock->stop_requested, 1, __ATOMIC_RELEASE);
+            return NULL;
+        case STALL_ABORT:
+            exit(EXIT_FAILURE);
+        default:
+            break;
+        }
+    }
+    return NULL;
+}
+
+// --- PARAMETER RELOAD ---
+// With --params the scenario can change while the simulation runs: the
+// reload thread re-reads the file when it changes (an inotify watch on its
+// directory, as editors often replace a file by renaming over it) or when
+// the process gets SIGHUP, and publishes the new snapshot to dock->params.
+// A file that does not parse is reported and the running scenario kept.
+// SIGHUP is blocked in every other thread, since the semaphore backends
+// do not restart a wait a signal handler interrupted; it is delivered to
+// the reload thread, whose handler only sets a flag.
+pthread_t reload_tid;
+int reload_signalled = 0;             // Set by the SIGHUP handler
+unsigned long reloads = 0, reloads_rejected = 0;
+unsigned long timed_departures = 0;   // Partial departures of the depart_after_ms policy
+
+void note_reload_signal(int sig) {
+    (void)sig;
+    __atomic_store_n(&reload_signalled, 1, __ATOMIC_RELAXED);
+}
+
+// Reads the --params file over the defaults. Returns -1, after saying
+// why, when it cannot be used.
+int load_params_file(scenario_params_t* p) {
+    char error[256];
+    params_defaults(p);
+    if (params_load(config.params_file, p, error, sizeof(error)) != 0) {
+        fprintf(stderr, "Parameters: %s\n", error);
+        return -1;
+    }
+    // A timed departure is forced through sem_full, like --on-stall depart.
+    if (p->depart_after_ms > 0 && config.cycle_barrier) {
+        fprintf(stderr, "Parameters: depart_after_ms needs --cycle semaphores\n");
+        return -1;
+    }
+    return 0;
+}
+
+void reload_params() {
+    scenario_params_t next;
+    if (load_params_file(&next) != 0) {
+        reloads_rejected++;
+        fprintf(stderr, "Parameters: reload rejected, keeping version %lu\n",
+                params_read(&dock->params).version);
+        return;
+    }
+    params_publish(&dock->params, &next);
+    reloads++;
+    scenario_params_t now = params_read(&dock->params);
+    fprintf(stderr, "Parameters: version %lu, boarding %ld-%ld ms, unboarding %ld-%ld ms, "
+            "driving %ld-%ld ms, crossing %ld ms, depart after %d ms\n", now.version,
+            now.board_min_us / 1000, (now.board_min_us + now.board_spread_us) / 1000,
+            now.unboard_min_us / 1000, (now.unboard_min_us + now.unboard_spread_us) / 1000,
+            now.drive_min_us / 1000, (now.drive_min_us + now.drive_spread_us) / 1000,
+            now.crossing_us / 1000, now.depart_after_ms);
+}
+
+#ifdef __linux__
+// Drains the watch; true when one of the events names the --params file.
+bool params_file_changed(int fd, const char* name) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool changed = false;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + n; ) {
+            struct inotify_event* ev = (struct inotify_event*)p;
+            if (ev->len > 0 && strcmp(ev->name, name) == 0) changed = true;
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    return changed;
+}
+#endif
+
+void* reload_thread(void* arg) {
+    (void)arg;
+    sigset_t hup;
+    sigemptyset(&hup);
+    sigaddset(&hup, SIGHUP);
+    pthread_sigmask(SIG_UNBLOCK, &hup, NULL);
+
+#ifdef __linux__
+    char dir[4096];
+    const char* slash = strrchr(config.params_file, '/');
+    const char* name = slash != NULL ? slash + 1 : config.params_file;
+    if (slash == NULL) snprintf(dir, sizeof(dir), ".");
+    else if (slash == config.params_file) snprintf(dir, sizeof(dir), "/");
+    else snprintf(dir, sizeof(dir), "%.*s", (int)(slash - config.params_file), config.params_file);
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    if (fd < 0) fprintf(stderr, "Parameters: cannot watch %s, reloading on SIGHUP only\n", dir);
+#endif
+
+    while (!__atomic_load_n(&dock->ferry_done, __ATOMIC_ACQUIRE)) {
+        bool changed = false;
+#ifdef __linux__
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (fd >= 0 && poll(&pfd, 1, WATCHDOG_POLL_US / 1000) > 0) changed = params_file_changed(fd, name);
+        else if (fd < 0) usleep(WATCHDOG_POLL_US);
+#else
+        usleep(WATCHDOG_POLL_US);
+#endif
+        if (__atomic_exchange_n(&reload_signalled, 0, __ATOMIC_RELAXED)) changed = true;
+        if (changed) reload_params();
+    }
+#ifdef __linux__
+    if (fd >= 0) close(fd);
+#endif
+    return NULL;
+}
+
+// Blocks SIGHUP in the calling thread and every thread or process it
+// starts from now on, and routes it to the reload flag.
+void block_reload_signal() {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = note_reload_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGHUP, &sa, NULL);
+    sigset_t hup;
+    sigemptyset(&hup);
+    sigaddset(&hup, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &hup, NULL);
+}
+
+// --- FERRY UTILIZATION ---
+// Where the ferry's time goes, collected on every run. The ferry thread is
+// the only writer and already reads the clock at each phase boundary, so a
+// cycle costs a handful of additions and one histogram increment. The car
+// timestamps it needs are taken under the mutex the cars already hold.
+typedef struct {
+    double phase_sec[FERRY_PHASES];        // Time spent in each phase
+    unsigned long cycles;                  // Departures measured
+    double load_sum;                       // Sum of per-departure load factors
+    double load_min;
+    unsigned long tail_hist[TAIL_BUCKETS]; // Wait for the last car, log2(us)
+    unsigned long full_cycles;             // Departures in the histogram
+    double tail_max;
+} ferry_stats_t;
+
+ferry_stats_t ferry_stats = { { 0 }, 0, 0, 1.0, { 0 }, 0, 0 };
+
+// Accounts one phase of the current cycle and exports it to the timeline.
+void ferry_phase(int phase, double start, double end) {
+    ferry_stats.phase_sec[phase] += end - start;
+    if (config.timeline != NULL) timeline_interval(phase, 0, -1, start, end);
+}
+
+void note_departure(int cars, int capacity, double last_car_wait) {
+    double load = (double)cars / capacity;
+    ferry_stats.cycles++;
+    ferry_stats.load_sum += load;
+    if (load < ferry_stats.load_min) ferry_stats.load_min = load;
+
+    if (cars < capacity) return;    // Partial departure: no last car
+    uint64_t us = last_car_wait > 0 ? (uint64_t)(last_car_wait * 1e6) : 0;
+    int bucket = 0;
+    while (bucket < TAIL_BUCKETS - 1 && (us >> (bucket + 1)) != 0) bucket++;
+    ferry_stats.tail_hist[bucket]++;
+    ferry_stats.full_cycles++;
+    if (last_car_wait > ferry_stats.tail_max) ferry_stats.tail_max = last_car_wait;
+}
+
+// Upper bound, in seconds, of the bucket holding the given quantile.
+double tail_quantile(double q) {
+    unsigned long rank = (unsigned long)(q * ferry_stats.full_cycles);
+    unsigned long seen = 0;
+    for (int b = 0; b < TAIL_BUCKETS; b++) {
+        seen += ferry_stats.tail_hist[b];
+        if (seen > rank) return (double)(2ULL << b) / 1e6;
+    }
+    return ferry_stats.tail_max;
+}
+
+void print_utilization() {
+    if (ferry_stats.cycles == 0) return;
+    double total = 0;
+    for (int p = 0; p < FERRY_PHASES; p++) total += ferry_stats.phase_sec[p];
+    if (total <= 0) total = 1;
+    print_summary("Ferry time over %lu departures: boarding (idle) %.1f%%, waiting for full %.1f%%, "
+                  "crossing %.1f%%, unboarding %.1f%%\n", ferry_stats.cycles,
+                  100 * ferry_stats.phase_sec[TL_BOARDING] / total,
+                  100 * ferry_stats.phase_sec[TL_WAITING_FULL] / total,
+                  100 * ferry_stats.phase_sec[TL_CROSSING] / total,
+                  100 * ferry_stats.phase_sec[TL_UNBOARDING] / total);
+    print_summary("Load factor: mean %.2f, min %.2f\n",
+                  ferry_stats.load_sum / ferry_stats.cycles, ferry_stats.load_min);
+    if (ferry_stats.full_cycles == 0) return;
+    print_summary("Wait for last car: p50 < %.3f ms, p90 < %.3f ms, p99 < %.3f ms, max %.3f ms\n",
+                  tail_quantile(0.5) * 1e3, tail_quantile(0.9) * 1e3,
+                  tail_quantile(0.99) * 1e3, ferry_stats.tail_max * 1e3);
+}
+
+// --- SCENARIO ---
+// A --scenario script is compiled at startup (scenario.h). The cars look
+// up the arrival rate factor and the ferry the crossing factor by time;
+// the ferry alone walks the event table, applying whatever became due
+// before each cycle: a maintenance window holds it at the dock, and a
+// capacity window sets the seats it offers until the window ends.
+scenario_t scenario;                  // Zeroed when no script: every factor is 1
+int scenario_cursor = 0;              // Next event to apply (ferry only)
+int maintenance_depth = 0;            // Open maintenance windows
+int vessel_capacity = 0;              // Seats of a replacement vessel, 0 = --capacity
+unsigned long scenario_events_applied = 0;
+unsigned long small_vessel_departures = 0;
+double maintenance_sec = 0;
+
+void apply_scenario_events(double now) {
+    char message[96];
+    while (scenario_cursor < scenario.event_count && scenario.events[scenario_cursor].at <= now) {
+        const scenario_event_t* e = &scenario.events[scenario_cursor++];
+        scenario_events_applied++;
+        switch (e->kind) {
+        case SCENARIO_MAINTENANCE_BEGIN: maintenance_depth++; break;
+        case SCENARIO_MAINTENANCE_END:   maintenance_depth--; break;
+        case SCENARIO_CAPACITY_BEGIN:
+            vessel_capacity = e->value;
+            snprintf(message, sizeof(message), "is replaced by a %d-seat vessel (line %d)", e->value, e->line);
+            LOG_STATUS(LOG_PHASE, message, -1);
+            break;
+        case SCENARIO_CAPACITY_END:
+            vessel_capacity = 0;
+            snprintf(message, sizeof(message), "is back with %d seats", config.capacity);
+            LOG_STATUS(LOG_PHASE, message, -1);
+            break;
+        }
+    }
+}
+
+// Applies the due events and waits out maintenance, still publishing
+// progress so the watchdog does not take it for a stall. Returns false
+// when the run ended during maintenance.
+bool run_scenario_events() {
+    double now = get_relative_time_sec();
+    apply_scenario_events(now);
+    if (maintenance_depth == 0) return true;
+    LOG_STATUS(LOG_PHASE, "goes out of service for maintenance", -1);
+    double began = now;
+    while (maintenance_depth > 0) {
+        if (now >= config.runtime_sec || __atomic_load_n(&dock->stop_requested, __ATOMIC_ACQUIRE)) {
+            maintenance_sec += now - began;
+            return false;
+        }
+        usleep(WATCHDOG_POLL_US);
+        note_progress(0, __atomic_load_n(&dock->ferry_state, __ATOMIC_RELAXED));
+        now = get_relative_time_sec();
+        apply_scenario_events(now);
+    }
+    maintenance_sec += now - began;
+    LOG_STATUS(LOG_PHASE, "returns to service", -1);
+    return true;
+}
+
+// Posts n permits, through the engine when n is the full capacity.
+void release_permits(sync_sem_t* sem, int n) {
+    if (n == config.capacity) engine->release_all(sem, n);
+    else for (int i = 0; i < n; i++) sync_post(sem);
+}
+
+// --- POLICY ---
+// A --policy other than the default semaphore is consulted under the dock
+// lock (policy.h). A policy that orders boarding replaces sem_board: each
+// car joins a queue and waits on its own grant, and whoever changes the
+// queue or the free seats hands the seats out in the order the policy
+// picks. A policy that decides departures is asked after every boarding
+// and every poll of the main thread, and sends a partly loaded ferry off
+// the way the watchdog does. Policies cannot cross --processes, as plugin
+// state and the grants live in this process.
+policy_t policy;                      // The default semaphore built-in when not given
+bool queue_boarding = false;          // The policy orders boarding
+ferry_waiting_car_t* waiting_cars = NULL; // Boarding queue, oldest first (dock lock)
+int waiting_count = 0;
+int permits_left = 0;                 // Seats of this cycle not granted yet (dock lock)
+sync_sem_t* car_grants = NULL;        // Per car id: its seat was granted
+
+// The policy's view of the dock. Called under the dock lock.
+void policy_view(ferry_dock_view_t* view, int car_id) {
+    view->now = get_relative_time_sec();
+    view->capacity = dock->cycle_capacity;
+    view->aboard = dock->cars_on_board;
+    view->queued = queue_boarding ? waiting_count : -1;
+    view->first_board_at = dock->cycle_first_board;
+    view->departures = dock->departures;
+    view->car_id = car_id;
+}
+
+// Hands the free seats to waiting cars in policy order. Called under the
+// dock lock.
+void grant_seats() {
+    if (permits_left == 0 || waiting_count == 0) return;
+    ferry_dock_view_t view;
+    policy_view(&view, -1);
+    while (permits_left > 0 && waiting_count > 0) {
+        int pick = policy_select(&policy, &view, waiting_cars, waiting_count);
+        int car_id = waiting_cars[pick].car_id;
+        memmove(&waiting_cars[pick], &waiting_cars[pick + 1],
+                sizeof(ferry_waiting_car_t) * (waiting_count - pick - 1));
+        view.queued = --waiting_count;
+        permits_left--;
+        sync_post(&car_grants[car_id]);
+    }
+}
+
+// The car side of queue boarding: returns once the car has a seat.
+void queue_for_boarding(int car_id) {
+    ferry_dock_view_t view;
+    lock_dock();
+    waiting_cars[waiting_count].car_id = car_id;
+    waiting_cars[waiting_count].queued_at = get_relative_time_sec();
+    waiting_count++;
+    policy_view(&view, car_id);
+    policy_notify(&policy, &view, FERRY_POLICY_QUEUED);
+    grant_seats();
+    unlock_dock();
+    sync_wait(&car_grants[car_id]);
+}
+
+// The ferry side: offers this cycle's seats.
+void open_boarding(int capacity) {
+    if (policy.kind == POLICY_SEMAPHORE) {
+        release_permits(&dock->sem_board, capacity);
+        return;
+    }
+    ferry_dock_view_t view;
+    lock_dock();
+    if (queue_boarding) permits_left = capacity;
+    policy_view(&view, -1);
+    policy_notify(&policy, &view, FERRY_POLICY_BOARDING);
+    if (queue_boarding) grant_seats();
+    unlock_dock();
+    if (!queue_boarding) release_permits(&dock->sem_board, capacity);
+}
+
+// Tells the policy about a boarding or a tick and lets it send the ferry
+// off partly loaded. Called under the dock lock. partial_requested stays
+// set until the ferry changes to FERRY_CROSSING under the lock, so a tick
+// while the ferry settles a departure never requests a second one.
+void consider_departure(ferry_policy_event_t event, int car_id) {
+    bool boarding = __atomic_load_n(&dock->ferry_state, __ATOMIC_ACQUIRE) == FERRY_BOARDING;
+    if (event == FERRY_POLICY_TICK && !boarding) return;
+    ferry_dock_view_t view;
+    policy_view(&view, car_id);
+    policy_notify(&policy, &view, event);
+    if (!policy_decides_departure(&policy) || !boarding || dock->cars_on_board == 0 ||
+        dock->cars_on_board >= dock->cycle_capacity ||
+        __atomic_load_n(&partial_requested, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    if (policy_depart(&policy, &view)) request_partial_departure(0);
+}
+
+// Reserves the boarding queue and one grant per car id of the run.
+int policy_reserve() {
+    if (!queue_boarding) return 0;
+    waiting_cars = counted_malloc(sizeof(ferry_waiting_car_t) * config.num_cars);
+    car_grants = counted_malloc(sizeof(sync_sem_t) * (total_cars + 1));
+    if (waiting_cars == NULL || car_grants == NULL) return -1;
+    for (int id = 0; id <= total_cars; id++) {
+        if (sync_init(&car_grants[id], SYNC_CONDVAR, NULL, 0) != 0) return -1;
+    }
+    return 0;
+}
+
+void policy_release() {
+    for (int id = 0; id <= total_cars && car_grants != NULL; id++) sync_destroy(&car_grants[id]);
+    counted_free(car_grants);
+    counted_free(waiting_cars);
+    policy_unload(&policy);
 }
 
 // --- FERRY THREAD ---
+// Called by the ferry when the watchdog woke it before the ferry was full.
+// Takes back the boarding permits no car has taken (the seats not granted
+// yet when the policy orders boarding), waits for the cars that took one
+// but have not boarded yet, and returns the departing load.
+int settle_partial_boarding(int capacity) {
+    int reclaimed = 0;
+    lock_dock();
+    if (queue_boarding) {
+        reclaimed = permits_left;
+        permits_left = 0;
+    } else {
+        while (reclaimed < capacity && sync_trywait(&dock->sem_board)) reclaimed++;
+    }
+
+    while (dock->cars_on_board < capacity - reclaimed) {
+        unlock_dock();
+        sched_yield();
+        lock_dock();
+    }
+    // A car filling the ferry after the watchdog's post posted sem_full too.
+    int load = dock->cars_on_board;
+    unlock_dock();
+    if (load == capacity) sync_wait(&dock->sem_full);
+    return load;
+}
+
 // Implements the Ferry logic: Boarding -> Crossing -> Unboarding -> Reset
 void* ferry_thread(void* arg) {
     (void)arg; // Unused parameter
-    print_status("arrives to new dock", -1);
+    log_thread_attach();
+    LOG_STATUS(LOG_PHASE, "arrives to new dock", -1);
 
     while (true) {
-        // Check if the simulation time is up before starting a new cycle
-        if (get_relative_time_sec() >= PROGRAM_RUNTIME) break;
+        // Check if the simulation time (or the stress cycle budget) is up
+        // before starting a new cycle
+        if (get_relative_time_sec() >= config.runtime_sec) break;
+        if (config.max_cycles > 0 && dock->departures >= config.max_cycles) break;
+
+        // Scenario events due by now; maintenance keeps the ferry here.
+        if (scenario.event_count > 0 && !run_scenario_events()) break;
+        int capacity = vessel_capacity > 0 ? vessel_capacity : config.capacity;
+
+        // The previous cycle is over, so its event records can be reused.
+        reset_cycle_events();
 
         // 1. BOARDING PHASE
         // The ferry posts 'capacity' number of semaphores to allow cars to board.
-        for (int i = 0; i < FERRY_CAPACITY; i++) {
-            sem_post(sem_board);
-        }
+        LOG_STATUS(LOG_DEBUG, "releases boarding permits", -1);
+        double released_at = get_relative_time_sec();
+        dock->cycle_prev_board = released_at;
+        dock->cycle_first_board = -1;
+        // Published to the cars by the permit posts below.
+        dock->cycle_capacity = capacity;
+        set_ferry_state(FERRY_BOARDING);
+        unsigned int boarded_seen = phase_generation(&dock->boarded);
+        open_boarding(capacity);
 
-        // Wait until the 'sem_full' signal is received from the last boarding car.
-        sem_wait(sem_full);
+        // Wait until the 'sem_full' signal is received from the last boarding
+        // car, or from the watchdog forcing a partial departure.
+        if (config.cycle_barrier) phase_wait(&dock->boarded, boarded_seen);
+        else sync_wait(&dock->sem_full);
+        int load = capacity;
+        if (__atomic_load_n(&partial_requested, __ATOMIC_ACQUIRE)) load = settle_partial_boarding(capacity);
 
         // Check time again before departing to avoid starting a trip after time is up.
-        if (get_relative_time_sec() >= PROGRAM_RUNTIME) break;
+        double full_at = get_relative_time_sec();
+        if (full_at >= config.runtime_sec) break;
+        // The last car posted sem_full after setting the cycle_* timestamps.
+        double first_board = dock->cycle_first_board >= 0 ? dock->cycle_first_board : full_at;
+        ferry_phase(TL_BOARDING, released_at, first_board);
+        ferry_phase(TL_WAITING_FULL, first_board, full_at);
 
         // 2. CROSSING PHASE
-        // Simulate travel time (3 Seconds)
-        print_status("leaves the dock", -1);
-        sleep(3); 
+        // Simulate travel time (3 Seconds unless --params says otherwise)
+        scenario_params_t params = params_read(&dock->params);
+        LOG_STATUS(LOG_PHASE, "leaves the dock", -1);
+        lock_dock();
+        check_departure(load);
+        set_ferry_state(FERRY_CROSSING);
+        // Cleared with the state change, so no request can slip in between
+        // and post sem_full for the next cycle.
+        __atomic_store_n(&partial_requested, 0, __ATOMIC_RELEASE);
+        record_event(EV_FERRY_DEPART, -1, true);
+        dock->departures++;
+        cars_carried += dock->cars_on_board;
+        note_departure(dock->cars_on_board, capacity, dock->cycle_last_car_wait);
+        if (capacity < config.capacity) small_vessel_departures++;
+        unlock_dock();
+        model_delay((long)(params.crossing_us * scenario_crossing(&scenario, full_at)), 0);
 
         // 3. UNBOARDING PHASE
-        print_status("arrives to new dock", -1);
+        LOG_STATUS(LOG_PHASE, "arrives to new dock", -1);
+        double arrived_at = get_relative_time_sec();
+        ferry_phase(TL_CROSSING, full_at, arrived_at);
+        lock_dock();
+        set_ferry_state(FERRY_UNBOARDING);
+        record_event(EV_FERRY_ARRIVE, -1, true);
+        unlock_dock();
         // Signal permission for cars to unboard.
-        for (int i = 0; i < FERRY_CAPACITY; i++) {
-            sem_post(sem_unboard);
+        LOG_STATUS(LOG_DEBUG, "releases unboarding permits", -1);
+        unsigned int emptied_seen = phase_generation(&dock->emptied);
+        if (config.cycle_barrier) {
+            phase_release(&dock->landed);
+        } else {
+            release_permits(&dock->sem_unboard, load);
         }
 
         // Wait until the 'sem_empty' signal is received from the last leaving car.
-        sem_wait(sem_empty);
+        if (config.cycle_barrier) phase_wait(&dock->emptied, emptied_seen);
+        else if (load > 0) sync_wait(&dock->sem_empty);
+        ferry_phase(TL_UNBOARDING, arrived_at, get_relative_time_sec());
+        log_cycle_end();
     }
+    __atomic_store_n(&dock->ferry_done, 1, __ATOMIC_RELEASE);
     return NULL;
 }
 
+// --- SHARDS ---
+// With --shards the cars are split across shard processes, each running
+// its own ferry and dock in its own memory, and a coordinator process
+// connected to every shard by a socket. A car that finishes a journey may
+// drive on to another shard (--transfer-percent): its thread sends the
+// car to the coordinator and parks until the coordinator routes a car to
+// this shard, which the thread then adopts, id and all. Cars are only
+// routed to shards with a parked thread, so no shard runs out of threads
+// and no arrival waits for one.
+//
+// Each shard keeps its own clock (its start time is taken after the fork,
+// as on a separate node) and estimates the coordinator's from time pings,
+// keeping the estimate of the fastest round trip as NTP does. Transfers
+// are stamped in the coordinator's timebase, so the receiving shard can
+// tell how long a car was on the road.
+shard_link_t shard_link;              // This shard's end of the coordinator link
+pthread_t shard_receiver_tid;
+int64_t clock_offset_us = 0;          // Coordinator clock minus ours
+int64_t best_rtt_us = -1;             // Round trip behind the offset estimate
+unsigned long sync_pings = 0;         // Answered time pings
+int64_t sync_rtt_sum_us = 0;
+__thread unsigned int transfer_seed;  // Per-thread, like chaos_seed
+
+// Cars routed here and not yet adopted, in arrival order. num_cars
+// entries suffice, as only parked threads are sent cars.
+typedef struct {
+    int car_id;
+    int64_t sent_at_us;      // Coordinator clock
+} arrival_t;
+
+arrival_t* arrivals = NULL;
+unsigned long arrivals_head = 0, arrivals_tail = 0;
+pthread_mutex_t arrivals_lock = PTHREAD_MUTEX_INITIALIZER;
+sync_sem_t arrivals_ready;            // One permit per car in the ring
+unsigned long transfers_out = 0, transfers_in = 0;
+int64_t transfer_wait_us = 0;         // Send-to-adopt time of the cars adopted
+
+int64_t shard_clock_us() {
+    return (int64_t)(get_relative_time_sec() * 1e6);
+}
+
+int64_t coordinator_clock_us() {
+    return shard_clock_us() + __atomic_load_n(&clock_offset_us, __ATOMIC_RELAXED);
+}
+
+int send_time_ping() {
+    shard_msg_t ping = { MSG_TIME_PING, shard_index, 1, { shard_clock_us() } };
+    return shard_send(&shard_link, &ping);
+}
+
+// Folds one ping round trip into the offset estimate.
+void note_time_pong(const shard_msg_t* pong) {
+    int64_t rtt = shard_clock_us() - pong->v[0];
+    sync_pings++;
+    sync_rtt_sum_us += rtt;
+    if (best_rtt_us < 0 || rtt <= best_rtt_us) {
+        best_rtt_us = rtt;
+        __atomic_store_n(&clock_offset_us, pong->v[1] - (pong->v[0] + rtt / 2), __ATOMIC_RELAXED);
+    }
+}
+
+// Reads the coordinator's messages: pongs and cars routed here. When the
+// coordinator goes away nothing more can arrive, so the shard stops.
+void* shard_receiver_thread(void* arg) {
+    (void)arg;
+    shard_msg_t msg;
+    while (shard_recv(&shard_link, &msg) == 1) {
+        if (msg.type == MSG_TIME_PONG) {
+            note_time_pong(&msg);
+        } else if (msg.type == MSG_TRANSFER) {
+            pthread_mutex_lock(&arrivals_lock);
+            arrival_t* a = &arrivals[arrivals_tail++ % config.num_cars];
+            a->car_id = (int)msg.v[0];
+            a->sent_at_us = msg.v[1];
+            pthread_mutex_unlock(&arrivals_lock);
+            sync_post(&arrivals_ready);
+        }
+    }
+    __atomic_store_n(&dock->stop_requested, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Sends the agent's car away, parks, and adopts the car routed here in
+// its place. Returns the id the thread now drives; a car whose send fails
+// (the coordinator is gone) stays.
+int transfer_car(car_agent_t* agent) {
+    shard_msg_t msg = { MSG_TRANSFER, shard_index, 2, { agent->id, coordinator_clock_us() } };
+    // The car stops being this shard's before it can be routed back here.
+    __atomic_store_n(&progress[agent->id].started, 0, __ATOMIC_RELEASE);
+    if (shard_send(&shard_link, &msg) != 0) {
+        __atomic_store_n(&progress[agent->id].started, 1, __ATOMIC_RELEASE);
+        return agent->id;
+    }
+    if (agent->log_journey) LOG_STATUS(LOG_EVENT, "drove to another port", agent->id);
+    __atomic_fetch_add(&transfers_out, 1, __ATOMIC_RELAXED);
+
+    sync_wait(&arrivals_ready);
+    pthread_mutex_lock(&arrivals_lock);
+    arrival_t a = arrivals[arrivals_head++ % config.num_cars];
+    pthread_mutex_unlock(&arrivals_lock);
+    __atomic_fetch_add(&transfer_wait_us, coordinator_clock_us() - a.sent_at_us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&transfers_in, 1, __ATOMIC_RELAXED);
+
+    agent->id = a.car_id;
+    agent->sampled = car_in_sample(agent->id);
+    agent->log_journey = agent->sampled;
+    __atomic_store_n(&progress[agent->id].started, 1, __ATOMIC_RELEASE);
+    note_progress(agent->id, CAR_ASHORE);
+    if (agent->log_journey) LOG_STATUS(LOG_EVENT, "arrived from another port", agent->id);
+    return agent->id;
+}
+
+// Reserves the arrival ring with the rest of the simulation storage.
+int shard_reserve() {
+    arrivals = counted_malloc(sizeof(arrival_t) * config.num_cars);
+    if (arrivals == NULL) return -1;
+    return sync_init(&arrivals_ready, SYNC_CONDVAR, NULL, 0);
+}
+
+// Estimates the clock offset before any car moves (the receiver is not
+// running yet, so the pongs are read here), then starts the receiver.
+void shard_start() {
+    for (int i = 0; i < 4; i++) {
+        shard_msg_t pong;
+        if (send_time_ping() != 0 || shard_recv(&shard_link, &pong) != 1 ||
+            pong.type != MSG_TIME_PONG) {
+            fprintf(stderr, "Shard %d lost its coordinator\n", shard_index);
+            exit(EXIT_FAILURE);
+        }
+        note_time_pong(&pong);
+    }
+    if (pthread_create(&shard_receiver_tid, NULL, shard_receiver_thread, NULL) != 0) {
+        perror("Failed to create shard receiver thread"); exit(EXIT_FAILURE);
+    }
+}
+
+// Reports to the coordinator once every car has stopped; its last message.
+void shard_finish(double run_sec) {
+    shard_msg_t msg = { MSG_STATS, shard_index, SHARD_STATS_VALUES, { 0 } };
+    msg.v[SHARD_STATS_DEPARTURES] = (int64_t)dock->departures;
+    msg.v[SHARD_STATS_JOURNEYS] = (int64_t)cars_carried;
+    msg.v[SHARD_STATS_RUN_US] = (int64_t)(run_sec * 1e6);
+    msg.v[SHARD_STATS_TRANSFERS_OUT] = (int64_t)transfers_out;
+    msg.v[SHARD_STATS_TRANSFERS_IN] = (int64_t)transfers_in;
+    msg.v[SHARD_STATS_TRANSFER_WAIT_US] = transfer_wait_us;
+    msg.v[SHARD_STATS_VIOLATIONS] = (int64_t)dock->check_violations;
+    // The receiver may still be counting pongs; stop it first.
+    pthread_cancel(shard_receiver_tid);
+    pthread_join(shard_receiver_tid, NULL);
+    msg.v[SHARD_STATS_MSGS_SENT] = (int64_t)shard_link.sent;
+    msg.v[SHARD_STATS_MSGS_RECEIVED] = (int64_t)shard_link.received;
+    msg.v[SHARD_STATS_BYTES] = (int64_t)shard_link.bytes;
+    msg.v[SHARD_STATS_SEND_NS] = (int64_t)shard_link.send_ns;
+    msg.v[SHARD_STATS_PINGS] = (int64_t)sync_pings;
+    msg.v[SHARD_STATS_RTT_US] = sync_rtt_sum_us;
+    msg.v[SHARD_STATS_OFFSET_US] = clock_offset_us;
+    shard_send(&shard_link, &msg);
+    shard_link_close(&shard_link);
+    sync_destroy(&arrivals_ready);
+    counted_free(arrivals);
+}
+
 // --- CAR THREAD ---
 // Implements the Car logic: Queue -> Board -> Wait -> Unboard -> Random Wait
 void* car_thread(void* arg) {
-    int car_id = *(int*)arg;
-    free(arg); // Free the memory allocated for the ID in main
+    car_agent_t* agent = (car_agent_t*)arg;
+    int car_id = agent->id;
+    log_thread_attach();
+    chaos_seed = (unsigned int)car_id * 2654435761u;
+    transfer_seed = chaos_seed ^ (unsigned int)shard_index;
+    __atomic_store_n(&progress[car_id].started, 1, __ATOMIC_RELEASE);
 
     // Infinite loop: Cars loop continuously. They are not destroyed but 
-    // cycle back to the queue, maintaining their IDs (1-5).
+    // cycle back to the queue, maintaining their IDs (1-N).
     while (true) {
         // Stop execution if time is up
-        if (get_relative_time_sec() >= PROGRAM_RUNTIME) break;
+        if (get_relative_time_sec() >= config.runtime_sec) break;
+        // The whole journey runs on one snapshot; a reload applies from the next.
+        scenario_params_t params = params_read(&dock->params);
 
         // --- 1. BOARDING PHASE ---
+        if (track_journeys) agent->queued_at = get_relative_time_sec();
+
         // Wait for the ferry to signal boarding permission.
-        sem_wait(sem_board); 
+        note_progress(car_id, CAR_QUEUED);
+        chaos_point(true);
+        if (queue_boarding) queue_for_boarding(car_id);
+        else sync_wait(&dock->sem_board);
+        chaos_point(true);
 
         // Critical Section: Incrementing car count
-        pthread_mutex_lock(&car_count_mutex);
+        lock_dock();
         
-        // Simulate physical boarding time (10-50ms).
+        // Simulate physical boarding time (10-50ms by default).
         // This prevents multiple threads from printing the exact same timestamp.
-        usleep((rand() % 40000) + 10000); 
+        model_delay(params.board_min_us, params.board_spread_us);
 
-        cars_on_board++;
-        print_status("entered the ferry", car_id);
+        dock->cars_on_board++;
+        agent->seat = engine->claim_seat(dock->seats, config.capacity);
+        agent->boarded_departure = dock->departures;
+        agent->landed_seen = phase_generation(&dock->landed);
+        check_boarding(agent);
+        // Decide whether this journey is logged: the id sample, then the tail filter.
+        agent->log_journey = agent->sampled;
+        agent->boarded_at = get_relative_time_sec();
+        if (config.tail_wait_sec > 0 &&
+            agent->boarded_at - agent->queued_at <= config.tail_wait_sec) {
+            agent->log_journey = false;
+        }
+        // Boarding timestamps for the ferry's utilization breakdown.
+        if (dock->cars_on_board == 1) dock->cycle_first_board = agent->boarded_at;
+        if (dock->cars_on_board == dock->cycle_capacity) dock->cycle_last_car_wait = agent->boarded_at - dock->cycle_prev_board;
+        dock->cycle_prev_board = agent->boarded_at;
+        if (agent->log_journey) LOG_STATUS(LOG_EVENT, "entered the ferry", car_id);
+        record_event(EV_CAR_BOARD, car_id, agent->log_journey);
         
         // If this is the last car to board (reaching capacity), signal the captain.
-        if (cars_on_board == FERRY_CAPACITY) {
-            sem_post(sem_full); 
+        if (dock->cars_on_board == dock->cycle_capacity && !config.cycle_barrier) {
+            chaos_point(false);
+            sync_post(&dock->sem_full);
         }
-        pthread_mutex_unlock(&car_count_mutex);
+        if (policy.kind != POLICY_SEMAPHORE) consider_departure(FERRY_POLICY_BOARDED, car_id);
+        note_progress(car_id, CAR_ABOARD);
+        unlock_dock();
+        // The barrier counts the boardings itself; its last arrival wakes the ferry.
+        if (config.cycle_barrier) phase_arrive(&dock->boarded, agent->seat);
 
         // --- 2. UNBOARDING PHASE ---
         // Wait for the ferry to reach the destination and signal unboarding.
-        sem_wait(sem_unboard); 
+        chaos_point(true);
+        if (config.cycle_barrier) phase_wait(&dock->landed, agent->landed_seen);
+        else sync_wait(&dock->sem_unboard);
+        note_progress(car_id, CAR_LEAVING);
+        chaos_point(true);
 
-        // Simulate physical unboarding time (5-25ms).
-        usleep((rand() % 20000) + 5000); 
-        print_status("left the ferry", car_id);
+        // Simulate physical unboarding time (5-25ms by default).
+        model_delay(params.unboard_min_us, params.unboard_spread_us);
+        if (agent->log_journey) LOG_STATUS(LOG_EVENT, "left the ferry", car_id);
 
         // Critical Section: Decrementing car count
-        pthread_mutex_lock(&car_count_mutex);
-        cars_on_board--;
+        lock_dock();
+        dock->cars_on_board--;
+        double left_at = track_journeys ? get_relative_time_sec() : 0;
+        if (config.timeline != NULL) {
+            timeline_interval(TL_SEAT, agent->seat + 1, car_id, agent->boarded_at, left_at);
+        }
+        engine->free_seat(dock->seats, agent->seat);
+        int seat = agent->seat;
+        agent->seat = -1;
+        check_unboarding(agent);
+        record_event(EV_CAR_UNBOARD, car_id, agent->log_journey);
+        if (config.reservoir_size > 0) offer_journey(agent, left_at);
         
         // If this is the last car to leave (ferry is empty), signal the captain.
-        if (cars_on_board == 0) {
-            sem_post(sem_empty); 
+        if (dock->cars_on_board == 0 && !config.cycle_barrier) {
+            chaos_point(false);
+            sync_post(&dock->sem_empty);
+        }
+        note_progress(car_id, CAR_ASHORE);
+        unlock_dock();
+        if (config.cycle_barrier) phase_arrive(&dock->emptied, seat);
+        log_cycle_end();
+
+        // A car may drive on to another shard instead of coming back here.
+        if (shard_index >= 0 && config.transfer_percent > 0 &&
+            (int)(rand_r(&transfer_seed) % 100) < config.transfer_percent) {
+            car_id = transfer_car(agent);
         }
-        pthread_mutex_unlock(&car_count_mutex);
 
         // --- 3. RETURN PHASE (Random Wait) ---
         // Simulate driving around the city before returning to the dock.
-        // Wait between 0.5s and 1.5s.
-        usleep((rand() % 1000000) + 500000);
+        // Wait between 0.5s and 1.5s by default; this sets the arrival rate,
+        // which a --scenario script may scale over time.
+        double rate = scenario_rate(&scenario, get_relative_time_sec());
+        model_delay((long)(params.drive_min_us / rate), (long)(params.drive_spread_us / rate));
     }
     return NULL;
 }
 
-int main() {
+// --- DOCK SETUP ---
+// Lays out the dock state, the progress slots and the heavy-mode trace
+// ring in one block, each part starting on its own cache line. In process
+// mode the block is a shm_open segment that also holds the cycle arena,
+// since car processes append records the ferry later recycles. The name is
+// unlinked as soon as the segment is mapped, so an aborted run leaves
+// nothing behind; the car processes inherit the mapping through fork.
+size_t align_line(size_t n) {
+    return (n + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+}
+
+int dock_create() {
+    bool shared = config.processes > 0;
+    size_t arena_size = arena_footprint(sizeof(sim_event_t), 2 * config.capacity + CYCLE_EVENT_SLACK);
+    size_t progress_at = align_line(sizeof(dock_t));
+    size_t trace_at = progress_at + align_line(sizeof(progress_slot_t) * (total_cars + 1));
+    size_t arena_at = trace_at;
+    if (config.check_mode == CHECK_HEAVY) arena_at += align_line(sizeof(trace_entry_t) * CHECK_TRACE_SIZE);
+    size_t total = arena_at + (shared ? arena_size : 0);
+
+    unsigned char* base;
+    if (shared) {
+        shm_unlink(DOCK_SHM_NAME);
+        int fd = shm_open(DOCK_SHM_NAME, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return -1;
+        shm_unlink(DOCK_SHM_NAME);
+        void* map = MAP_FAILED;
+        if (ftruncate(fd, (off_t)total) == 0) {
+            map = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (map == MAP_FAILED) return -1;
+        dock_block = map;
+        dock_size = total;
+        base = map;
+    } else {
+        dock_block = counted_malloc(total + CACHE_LINE);
+        if (dock_block == NULL) return -1;
+        base = (unsigned char*)(((uintptr_t)dock_block + CACHE_LINE - 1) &
+                                ~(uintptr_t)(CACHE_LINE - 1));
+    }
+    memset(base, 0, total);
+    dock = (dock_t*)base;
+    progress = (progress_slot_t*)(base + progress_at);
+    if (config.check_mode == CHECK_HEAVY) check_trace = (trace_entry_t*)(base + trace_at);
+
+    if (shared) arena_init_at(&dock->cycle_arena, base + arena_at, arena_size);
+    else if (arena_init(&dock->cycle_arena, arena_size) != 0) return -1;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if (shared) pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&dock->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    dock->ferry_state = FERRY_BOARDING;
+    dock->cycle_first_board = -1;
+    dock->cycle_capacity = config.capacity;
+    params_init(&dock->params, &startup_params);
+    if (phase_init(&dock->boarded, config.capacity, config.barrier_fanin, shared) != 0 ||
+        phase_init(&dock->landed, config.capacity, 0, shared) != 0 ||
+        phase_init(&dock->emptied, config.capacity, config.barrier_fanin, shared) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void dock_destroy() {
+    arena_destroy(&dock->cycle_arena);
+    pthread_mutex_destroy(&dock->lock);
+    sync_destroy(&dock->sem_board);
+    sync_destroy(&dock->sem_full);
+    sync_destroy(&dock->sem_unboard);
+    sync_destroy(&dock->sem_empty);
+    if (config.processes > 0) munmap(dock_block, dock_size);
+    else counted_free(dock_block);
+    dock = NULL;
+    progress = NULL;
+    check_trace = NULL;
+}
+
+// --- CAR PROCESSES ---
+// Takes an agent from the pool and starts its car thread.
+car_agent_t* start_car(int id, pthread_t* tid, pthread_attr_t* attr) {
+    // Random delay before creating each of the first FERRY_CAPACITY cars
+    // (of each shard); any extra cars join the queue straight away.
+    if (id < first_car_id + FERRY_CAPACITY) model_delay(1000, 999000);
+
+    car_agent_t* agent = pool_get(&car_pool);
+    agent->id = id;
+    agent->seat = -1;
+    agent->sampled = car_in_sample(agent->id);
+    agent->log_journey = agent->sampled;
+    if (pthread_create(tid, attr, car_thread, agent) != 0) {
+        perror("Failed to create car thread"); exit(EXIT_FAILURE);
+    }
+    return agent;
+}
+
+// Runs cars first_id .. first_id + count - 1 as threads of this process.
+// A car process has no ferry: it stops its cars once the ferry is done,
+// the watchdog asked for a shutdown, or the parent died (an aborted run),
+// then exits without returning to main.
+void run_car_process(int first_id, int count, unsigned int seed, pid_t parent) {
+    srand(seed ^ (unsigned int)getpid());
+
+    pthread_t* threads = counted_malloc(sizeof(pthread_t) * count);
+    if (threads == NULL) { perror("Failed to reserve car threads"); exit(EXIT_FAILURE); }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, CAR_STACK_SIZE);
+    for (int i = 0; i < count; i++) start_car(first_id + i, &threads[i], &attr);
+    pthread_attr_destroy(&attr);
+
+    while (!__atomic_load_n(&dock->ferry_done, __ATOMIC_ACQUIRE) &&
+           !__atomic_load_n(&dock->stop_requested, __ATOMIC_ACQUIRE) &&
+           getppid() == parent) {
+        usleep(WATCHDOG_POLL_US);
+    }
+    for (int i = 0; i < count; i++) pthread_cancel(threads[i]);
+    for (int i = 0; i < count; i++) pthread_join(threads[i], NULL);
+    log_shutdown();
+    exit(0);
+}
+
+// Cars of part `part` when the cars are split evenly into `parts` (the
+// first parts take the remainder).
+int split_cars(int parts, int part) {
+    return config.num_cars / parts + (part < config.num_cars % parts);
+}
+
+// Forks config.processes car processes into pids, splitting the cars
+// with split_cars.
+void start_car_processes(pid_t* pids, unsigned int seed) {
+    pid_t parent = getpid();
+    // Line buffering keeps lines whole, and roughly in time order, when
+    // several processes share stdout. Nothing buffered is printed twice.
+    fflush(stdout);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    int first_id = 1;
+    for (int p = 0; p < config.processes; p++) {
+        int count = split_cars(config.processes, p);
+        pids[p] = fork();
+        if (pids[p] < 0) { perror("Failed to fork car process"); exit(EXIT_FAILURE); }
+        if (pids[p] == 0) run_car_process(first_id, count, seed, parent);
+        first_id += count;
+    }
+}
+
+// Waits for every car process; returns how many did not exit cleanly.
+int wait_car_processes(pid_t* pids) {
+    int failed = 0;
+    for (int p = 0; p < config.processes; p++) {
+        int status;
+        if (waitpid(pids[p], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "Car process %d (pid %d) did not exit cleanly\n", p, (int)pids[p]);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+// --- SHARD PROCESSES ---
+// Prints the coordinator's table: what each shard simulated, and what the
+// messaging cost it (mean transfer wait, messages, bytes, time in sends,
+// time ping round trips and the clock offset it settled on).
+void print_shard_report(int64_t (*stats)[SHARD_STATS_VALUES], const int* finished,
+                        const coordinator_stats_t* routing) {
+    print_summary("Shards: %d processes, %d cars, %d%% transfers per journey (%s backend)\n",
+                  config.shards, total_cars, config.transfer_percent, sync_backend_name(config.sync));
+    print_summary("  %5s %6s %10s %10s %10s %7s %7s %8s %7s %9s %8s %7s %9s\n",
+                  "Shard", "Cars", "Departures", "Journeys", "Journeys/s", "Out", "In",
+                  "Wait ms", "Msgs", "Bytes", "Send us", "RTT us", "Offset us");
+    double rate = 0, send_sec = 0, run_sec = 0;
+    int64_t departures = 0, journeys = 0, messages = 0, bytes = 0;
+    for (int s = 0; s < config.shards; s++) {
+        if (!finished[s]) {
+            print_summary("  %5d %6d did not report\n", s, split_cars(config.shards, s));
+            continue;
+        }
+        const int64_t* v = stats[s];
+        double sec = v[SHARD_STATS_RUN_US] / 1e6;
+        int64_t sent = v[SHARD_STATS_MSGS_SENT];
+        print_summary("  %5d %6d %10lld %10lld %10.0f %7lld %7lld %8.3f %7lld %9lld %8.2f %7.1f %9lld\n",
+                      s, split_cars(config.shards, s),
+                      (long long)v[SHARD_STATS_DEPARTURES], (long long)v[SHARD_STATS_JOURNEYS],
+                      sec > 0 ? v[SHARD_STATS_JOURNEYS] / sec : 0.0,
+                      (long long)v[SHARD_STATS_TRANSFERS_OUT], (long long)v[SHARD_STATS_TRANSFERS_IN],
+                      v[SHARD_STATS_TRANSFERS_IN] ? v[SHARD_STATS_TRANSFER_WAIT_US] / 1e3 / v[SHARD_STATS_TRANSFERS_IN] : 0.0,
+                      (long long)(sent + v[SHARD_STATS_MSGS_RECEIVED]), (long long)v[SHARD_STATS_BYTES],
+                      sent ? v[SHARD_STATS_SEND_NS] / 1e3 / sent : 0.0,
+                      v[SHARD_STATS_PINGS] ? (double)v[SHARD_STATS_RTT_US] / v[SHARD_STATS_PINGS] : 0.0,
+                      (long long)v[SHARD_STATS_OFFSET_US]);
+        rate += sec > 0 ? v[SHARD_STATS_JOURNEYS] / sec : 0.0;
+        run_sec += sec;
+        send_sec += v[SHARD_STATS_SEND_NS] / 1e9;
+        departures += v[SHARD_STATS_DEPARTURES];
+        journeys += v[SHARD_STATS_JOURNEYS];
+        messages += sent + v[SHARD_STATS_MSGS_RECEIVED];
+        bytes += v[SHARD_STATS_BYTES];
+    }
+    print_summary("  Total: %lld departures, %lld journeys (%.0f journeys/s across shards)\n",
+                  (long long)departures, (long long)journeys, rate);
+    print_summary("Coordinator: %lu transfers routed, %lu dropped, %lu time pings\n",
+                  routing->routed, routing->dropped, routing->pings);
+    print_summary("Messaging: %lld shard messages, %.2f per journey, %.1f bytes per journey, "
+                  "%.3f%% of shard time in sends\n",
+                  (long long)messages, journeys ? (double)messages / journeys : 0.0,
+                  journeys ? (double)bytes / journeys : 0.0,
+                  run_sec > 0 ? 100.0 * send_sec / run_sec : 0.0);
+}
+
+// SIGHUP to the coordinator reloads every shard's parameters.
+pid_t* reload_forward_pids = NULL;
+int reload_forward_count = 0;
+
+void forward_reload_signal(int sig) {
+    for (int s = 0; s < reload_forward_count; s++) kill(reload_forward_pids[s], sig);
+}
+
+// Forks config.shards shard processes, each linked to this process by a
+// socketpair, splitting the cars like start_car_processes. Returns false
+// in a shard, which goes on to run its own simulation; in this process it
+// coordinates the shards and returns true with the run's exit status once
+// every shard has reported.
+bool run_shards(unsigned int seed, int* status) {
+    shard_link_t* links = counted_malloc(sizeof(shard_link_t) * config.shards);
+    pid_t* pids = counted_malloc(sizeof(pid_t) * config.shards);
+    int64_t (*stats)[SHARD_STATS_VALUES] = counted_malloc(sizeof(*stats) * config.shards);
+    int* finished = counted_malloc(sizeof(int) * config.shards);
+    if (links == NULL || pids == NULL || stats == NULL || finished == NULL) {
+        perror("Failed to reserve shard storage"); exit(EXIT_FAILURE);
+    }
+    // As with car processes, line buffering keeps the shards' lines whole.
+    fflush(stdout);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    int first_id = 1;
+    for (int s = 0; s < config.shards; s++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            perror("Failed to link shard"); exit(EXIT_FAILURE);
+        }
+        pids[s] = fork();
+        if (pids[s] < 0) { perror("Failed to fork shard"); exit(EXIT_FAILURE); }
+        if (pids[s] == 0) {
+            // Only the coordinator may hold the other shards' links, or
+            // it would not see a shard hang up.
+            for (int o = 0; o < s; o++) close(links[o].fd);
+            close(fds[0]);
+            counted_free(links);
+            counted_free(pids);
+            counted_free(stats);
+            counted_free(finished);
+            shard_index = s;
+            first_car_id = first_id;
+            config.num_cars = split_cars(config.shards, s);
+            shard_link_init(&shard_link, fds[1]);
+            srand(seed ^ (unsigned int)getpid());
+            gettimeofday(&start_time, NULL);
+            return false;
+        }
+        close(fds[1]);
+        shard_link_init(&links[s], fds[0]);
+        first_id += split_cars(config.shards, s);
+    }
+
+    if (config.params_file != NULL) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = forward_reload_signal;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        reload_forward_pids = pids;
+        reload_forward_count = config.shards;
+        sigaction(SIGHUP, &sa, NULL);
+    }
+
+    coordinator_stats_t routing;
+    shard_coordinate(links, config.shards, shard_clock_us, stats, finished, &routing);
+    reload_forward_count = 0;      // The pids are about to be reaped
+
+    int failed = 0;
+    for (int s = 0; s < config.shards; s++) {
+        int wstatus;
+        if (waitpid(pids[s], &wstatus, 0) < 0 || !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+            fprintf(stderr, "Shard %d (pid %d) did not exit cleanly\n", s, (int)pids[s]);
+            failed++;
+        } else if (!finished[s] || stats[s][SHARD_STATS_VIOLATIONS] > 0) {
+            failed++;
+        }
+        shard_link_close(&links[s]);
+    }
+    print_shard_report(stats, finished, &routing);
+
+    counted_free(links);
+    counted_free(pids);
+    counted_free(stats);
+    counted_free(finished);
+    *status = failed > 0 ? EXIT_FAILURE : 0;
+    return true;
+}
+
+// --- HARDWARE COUNTERS ---
+// Opens a dTLB load counter for this process and every thread it creates
+// afterwards. Returns -1 when perf events are unavailable (non-Linux,
+// containers, perf_event_paranoid), in which case the report says so.
+int open_dtlb_counter(bool misses) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  ((misses ? PERF_COUNT_HW_CACHE_RESULT_MISS
+                           : PERF_COUNT_HW_CACHE_RESULT_ACCESS) << 16);
+    attr.inherit = 1;          // Count the ferry and car threads too
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)misses;
+    return -1;
+#endif
+}
+
+// Reads a counter opened by open_dtlb_counter and closes it.
+bool read_counter(int fd, uint64_t* value) {
+    if (fd < 0) return false;
+    bool ok = read(fd, value, sizeof(*value)) == (ssize_t)sizeof(*value);
+    close(fd);
+    return ok;
+}
+
+// --- ENGINE BENCHMARK ---
+// Times the capacity-dependent part of a ferry cycle (boarding release,
+// seat claims, seat releases, unboarding release) without any modeled
+// delays, for each specialized engine against the generic one. With
+// sem == NULL only the seat bookkeeping is timed, which isolates the
+// engine code from the semaphore cost.
+double bench_engine_cycle(const ferry_engine_t* eng, int capacity, sync_sem_t* sem) {
+    uint64_t bench_seats[SEAT_WORDS] = { 0 };
+    int taken[MAX_CAPACITY];
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int cycle = 0; cycle < BENCH_CYCLES; cycle++) {
+        if (sem != NULL) eng->release_all(sem, capacity);
+        for (int i = 0; i < capacity; i++) {
+            if (sem != NULL) sync_wait(sem);
+            taken[i] = eng->claim_seat(bench_seats, capacity);
+        }
+        if (sem != NULL) eng->release_all(sem, capacity);
+        for (int i = 0; i < capacity; i++) {
+            if (sem != NULL) sync_wait(sem);
+            eng->free_seat(bench_seats, taken[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    return ns / BENCH_CYCLES;
+}
+
+void run_engine_benchmark() {
+    static const int capacities[] = { 5, 10, 20, 50 };
+
+    sync_sem_t sem;
+    if (sync_init(&sem, config.sync, "/sem_bench", 0) != 0) {
+        perror("Failed to create benchmark semaphore"); exit(EXIT_FAILURE);
+    }
+
+    printf("capacity,engine,part,ns_per_cycle,generic_ns_per_cycle,speedup\n");
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++) {
+        int capacity = capacities[i];
+        const ferry_engine_t* fixed = select_engine(capacity, false);
+        const ferry_engine_t* generic = select_engine(capacity, true);
+
+        for (int part = 0; part < 2; part++) {
+            sync_sem_t* part_sem = part == 0 ? NULL : &sem;
+            double fixed_ns = bench_engine_cycle(fixed, capacity, part_sem);
+            double generic_ns = bench_engine_cycle(generic, capacity, part_sem);
+            printf("%d,%s,%s,%.1f,%.1f,%.2f\n", capacity, fixed->name,
+                   part == 0 ? "seats" : "seats+semaphores",
+                   fixed_ns, generic_ns, generic_ns / fixed_ns);
+        }
+    }
+
+    sync_destroy(&sem);
+}
+
+// --- LOG SINK BENCHMARK ---
+// Streams BENCH_LOG_BYTES of log lines through each sink into --log-file,
+// in chunks the size of a full per-thread buffer. Reports the wall time
+// (including the final drain and close), the time the producer spent
+// blocked inside sink_write, and the number of output system calls.
+// Point --log-file at an NVMe-backed and a tmpfs-backed path to compare.
+void run_log_benchmark() {
+    static const sink_kind_t kinds[] = { SINK_WRITE, SINK_URING, SINK_MMAP };
+    static char chunk[LOG_BUFFER_SIZE];
+
+    if (config.log_file == NULL) {
+        fprintf(stderr, "--bench log needs --log-file PATH\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Fill the chunk with realistic lines.
+    size_t used = 0;
+    for (int car = 1; ; car++) {
+        char line[64];
+        int len = snprintf(line, sizeof(line), "[Clock : %.4f] Car %d entered the ferry\n",
+                           car * 0.0137, car);
+        if (used + len > sizeof(chunk)) break;
+        memcpy(chunk + used, line, len);
+        used += len;
+    }
+
+    printf("sink,path,bytes,seconds,mb_per_s,blocked_seconds,syscalls\n");
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        struct timespec t0, t1, w0, w1;
+        double blocked = 0.0;
+        unsigned long calls0 = sink_syscalls();
+
+        int kind = sink_open(kinds[i], config.log_file);
+        if (kind < 0) { perror("Failed to open log file"); exit(EXIT_FAILURE); }
+        if (kind != (int)kinds[i]) { sink_close(); continue; }
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long written = 0; written < BENCH_LOG_BYTES; written += used) {
+            clock_gettime(CLOCK_MONOTONIC, &w0);
+            sink_write(chunk, used);
+            clock_gettime(CLOCK_MONOTONIC, &w1);
+            blocked += (w1.tv_sec - w0.tv_sec) + (w1.tv_nsec - w0.tv_nsec) / 1e9;
+        }
+        sink_close();
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        printf("%s,%s,%ld,%.3f,%.1f,%.3f,%lu\n", sink_kind_name(kinds[i]), config.log_file,
+               BENCH_LOG_BYTES, secs, BENCH_LOG_BYTES / secs / 1e6, blocked,
+               sink_syscalls() - calls0);
+    }
+    unlink(config.log_file);
+}
+
+// --- LOG LEVEL BENCHMARK ---
+// Cost of one suppressed log statement on the hot path, next to an empty
+// loop: a statement compiled out (level above LOG_COMPILE_LEVEL), one
+// filtered by the runtime level, and the old style that takes the
+// timestamp before deciding to drop the line.
+#define BENCH_COMPILED_OUT(level) \
+    do { if ((level) <= LOG_NONE && (level) <= log_level) print_status("bench", 0); } while (0)
+
+double bench_elapsed_ns(struct timespec t0, struct timespec t1) {
+    return (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+}
+
+void run_log_level_benchmark() {
+    struct timespec t0, t1;
+    volatile unsigned long sink = 0;   // Keeps the loops from being removed
+    int saved_level = log_level;
+    log_level = LOG_NONE;
+
+    printf("case,ns_per_statement\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < BENCH_LOG_CALLS; i++) sink = sink + 1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("empty_loop,%.3f\n", bench_elapsed_ns(t0, t1) / BENCH_LOG_CALLS);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < BENCH_LOG_CALLS; i++) {
+        sink = sink + 1;
+        BENCH_COMPILED_OUT(LOG_EVENT);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("compiled_out,%.3f\n", bench_elapsed_ns(t0, t1) / BENCH_LOG_CALLS);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < BENCH_LOG_CALLS; i++) {
+        sink = sink + 1;
+        LOG_STATUS(LOG_EVENT, "bench", 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("runtime_filtered,%.3f\n", bench_elapsed_ns(t0, t1) / BENCH_LOG_CALLS);
+
+    // The timestamp is the expensive part, so this case runs fewer times.
+    long calls = BENCH_LOG_CALLS / 10;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < calls; i++) {
+        if (get_relative_time_sec() > config.runtime_sec + 1e9) print_status("bench", 0);
+        sink = sink + 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("timestamp_then_filter,%.3f\n", bench_elapsed_ns(t0, t1) / calls);
+
+    log_level = saved_level;
+}
+
+// --- POLICY BENCHMARK ---
+// Cost of one policy decision through the simulator's dispatch. Each
+// built-in runs twice: called directly by kind, as the simulation does,
+// and through its callback table, as if it were a plugin, which prices
+// the indirect call the switch saves. A --policy plugin runs through its
+// own table. The queue length cycles so eager's answer varies. Noise only
+// ever adds time, so each row is the best of a few trials.
+#define BENCH_POLICY_CALLS 10000000L
+#define BENCH_POLICY_TRIALS 3
+#define BENCH_POLICY_QUEUE 8   // Waiting cars per decision (power of two)
+
+double bench_policy_decisions(policy_t* p, bool depart) {
+    ferry_waiting_car_t waiting[BENCH_POLICY_QUEUE];
+    for (int i = 0; i < BENCH_POLICY_QUEUE; i++) {
+        waiting[i].car_id = i + 1;
+        waiting[i].queued_at = i * 0.001;
+    }
+    ferry_dock_view_t view = { 0, config.capacity, 1, BENCH_POLICY_QUEUE, 0, 0, -1 };
+    volatile long sink = 0;    // Keeps the decisions from being removed
+    double best = 0;
+    for (int trial = 0; trial < BENCH_POLICY_TRIALS; trial++) {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (long i = 0; i < BENCH_POLICY_CALLS; i++) {
+            view.queued = (int)(i & (BENCH_POLICY_QUEUE - 1));
+            if (depart) sink = sink + policy_depart(p, &view);
+            else sink = sink + policy_select(p, &view, waiting, BENCH_POLICY_QUEUE);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ns = bench_elapsed_ns(t0, t1) / BENCH_POLICY_CALLS;
+        if (trial == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+void bench_policy_rows(policy_t* p, const char* dispatch) {
+    if (policy_orders_boarding(p)) {
+        printf("%s,select,%s,%ld,%.3f\n", policy_name(p), dispatch, BENCH_POLICY_CALLS,
+               bench_policy_decisions(p, false));
+    }
+    if (policy_decides_departure(p)) {
+        printf("%s,depart,%s,%ld,%.3f\n", policy_name(p), dispatch, BENCH_POLICY_CALLS,
+               bench_policy_decisions(p, true));
+    }
+}
+
+void run_policy_benchmark() {
+    static const char* builtin_names[] = { "fifo", "random", "eager" };
+    char error[512];
+    printf("policy,decision,dispatch,calls,ns_per_decision\n");
+    for (size_t i = 0; i < sizeof(builtin_names) / sizeof(builtin_names[0]); i++) {
+        policy_t p;
+        if (policy_load(&p, builtin_names[i], config.policy_args, error, sizeof(error)) != 0) {
+            fprintf(stderr, "Policy: %s\n", error);
+            exit(EXIT_FAILURE);
+        }
+        bench_policy_rows(&p, "direct");
+        // The same callbacks, reached the way a plugin's are.
+        policy_t as_plugin = p;
+        as_plugin.kind = POLICY_PLUGIN;
+        bench_policy_rows(&as_plugin, "table");
+        policy_unload(&p);
+    }
+    if (policy.kind == POLICY_PLUGIN) bench_policy_rows(&policy, "plugin");
+}
+
+// --- RESULTS STORE ---
+// Appends this run's configuration and metrics as one row. Sweeps simply
+// run the simulator once per point with the same --results file.
+void append_results(unsigned int seed, double elapsed, unsigned long alloc_calls) {
+    static const char names[][RESULTS_NAME_LEN] = {
+        "started_at", "seed", "runtime_sec", "cars", "capacity", "events",
+        "departures", "mean_load", "events_per_sec", "alloc_calls"
+    };
+    double row[] = {
+        (double)start_time.tv_sec, seed, config.runtime_sec, config.num_cars,
+        config.capacity, dock->events_logged, dock->departures,
+        dock->departures ? (double)cars_carried / dock->departures : 0.0,
+        elapsed > 0 ? dock->events_logged / elapsed : 0.0, alloc_calls
+    };
+    char tag[1][RESULTS_TAG_LEN] = { { 0 } };
+    strncpy(tag[0], config.run_tag, RESULTS_TAG_LEN - 1);
+
+    int columns = sizeof(names) / sizeof(names[0]);
+    if (results_append(config.results, columns, names, 1, row, (const char (*)[RESULTS_TAG_LEN])tag) != 0) {
+        fprintf(stderr, "Failed to append results to %s (missing or different schema?)\n",
+                config.results);
+    }
+}
+
+// --- COMMAND LINE ---
+void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --runtime SEC        simulation length in seconds (default %d)\n"
+            "  --cars N             number of cars (default %d)\n"
+            "  --capacity N         cars per crossing, 1..%d (default %d)\n"
+            "  --generic-engine     do not use the capacity-specialized engines\n"
+            "  --hugepages MODE     back large arrays with huge pages:\n"
+            "                       normal, transparent or explicit (default normal)\n"
+            "  --log-buffer POLICY  buffer log lines per thread, one write per flush:\n"
+            "                       latency (every cycle), throughput (when full)\n"
+            "                       or N (every N lines)\n"
+            "  --log-file PATH      write the log to PATH instead of stdout\n"
+            "  --event-log PATH     also write a compressed binary event log to PATH\n"
+            "  --timeline PATH      write ferry phase and seat intervals to PATH\n"
+            "                       (render with ferry_gantt)\n"
+            "  --results PATH       append this run's metrics to a columnar results file\n"
+            "  --run-tag TAG        label stored with the run's results\n"
+            "  --log-sink SINK      buffered output sink: write, uring or mmap\n"
+            "                       (default write)\n"
+            "  --bench NAME         run a benchmark instead of the simulation:\n"
+            "                       engine, log (needs --log-file), log-level, policy\n"
+            "  --sample-1-in N      log only cars whose id hash falls in 1 of N buckets\n"
+            "  --tail-wait-ms MS    log only journeys that waited longer than MS\n"
+            "  --reservoir K        report K randomly sampled complete journeys at exit\n"
+            "  --check MODE         invariant checks: off, on or heavy (default on)\n"
+            "  --sync BACKEND       permit semaphores: named, unnamed, condvar, futex,\n"
+            "                       spin or eventfd (default named)\n"
+            "  --stress             no modeled delays, stall watchdog, throughput report\n"
+            "  --cycles N           stop after N departures\n"
+            "  --chaos PERCENT      inject a yield or short sleep at PERCENT of sync points\n"
+            "  --watchdog-ms MS     report a stall when no agent progresses for MS\n"
+            "                       (default off, %d with --stress)\n"
+            "  --on-stall ACTION    report, depart (partially loaded), shutdown or abort\n"
+            "                       (default report, abort with --stress)\n"
+            "  --processes N        run the cars in N processes sharing the dock in\n"
+            "                       shared memory (default 0, cars are threads)\n"
+            "  --shards N           split the cars across N shard processes, each with\n"
+            "                       its own ferry, under a coordinator (default 0)\n"
+            "  --transfer-percent P chance a car drives on to another shard after a\n"
+            "                       journey (default 0)\n"
+            "  --cycle MODE         full/unboard/empty handoffs: semaphores or barrier\n"
+            "                       (default semaphores)\n"
+            "  --barrier-fanin F    combining tree fan-in of the barriers (default 0, flat)\n"
+            "  --params PATH        read delays and departure policy from PATH, and reload\n"
+            "                       them when it changes or on SIGHUP\n"
+            "  --scenario PATH      run the rate, crossing, maintenance and capacity\n"
+            "                       windows of the script at PATH\n"
+            "  --policy NAME|PATH   departure and boarding policy: semaphore, fifo, random,\n"
+            "                       eager, or a plugin shared object (default semaphore)\n"
+            "  --policy-args STR    argument string passed to the policy\n"
+            "  --log-level LEVEL    none, summary, phase, event or debug (default event)\n",
+            prog, PROGRAM_RUNTIME, FERRY_CAPACITY, MAX_CAPACITY, FERRY_CAPACITY, STRESS_STALL_MS);
+}
+
+void parse_args(int argc, char* argv[]) {
+    static const struct option options[] = {
+        { "runtime",   required_argument, NULL, 'r' },
+        { "cars",      required_argument, NULL, 'c' },
+        { "capacity",  required_argument, NULL, 'k' },
+        { "generic-engine", no_argument,  NULL, 'g' },
+        { "hugepages", required_argument, NULL, 'H' },
+        { "bench",     required_argument, NULL, 'b' },
+        { "log-buffer", required_argument, NULL, 'L' },
+        { "log-file",  required_argument, NULL, 'f' },
+        { "log-sink",  required_argument, NULL, 'S' },
+        { "event-log", required_argument, NULL, 'E' },
+        { "timeline",  required_argument, NULL, 'G' },
+        { "results",   required_argument, NULL, 'R' },
+        { "run-tag",   required_argument, NULL, 'T' },
+        { "log-level", required_argument, NULL, 'l' },
+        { "sample-1-in", required_argument, NULL, 'N' },
+        { "tail-wait-ms", required_argument, NULL, 'W' },
+        { "reservoir", required_argument, NULL, 'V' },
+        { "check",     required_argument, NULL, 'C' },
+        { "sync",      required_argument, NULL, 'Y' },
+        { "stress",    no_argument,       NULL, 's' },
+        { "cycles",    required_argument, NULL, 'n' },
+        { "chaos",     required_argument, NULL, 'X' },
+        { "watchdog-ms", required_argument, NULL, 'w' },
+        { "on-stall",  required_argument, NULL, 'A' },
+        { "processes", required_argument, NULL, 'P' },
+        { "shards",    required_argument, NULL, 'D' },
+        { "transfer-percent", required_argument, NULL, 'x' },
+        { "cycle",     required_argument, NULL, 'y' },
+        { "barrier-fanin", required_argument, NULL, 'F' },
+        { "params",    required_argument, NULL, 'p' },
+        { "scenario",  required_argument, NULL, 'Z' },
+        { "policy",    required_argument, NULL, 'o' },
+        { "policy-args", required_argument, NULL, 'O' },
+        { "help",      no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int opt, backend;
+    bool level_given = false, action_given = false;
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'r': config.runtime_sec = atoi(optarg); break;
+        case 'c': config.num_cars = atoi(optarg); break;
+        case 'k': config.capacity = atoi(optarg); break;
+        case 'g': config.generic_engine = true; break;
+        case 'b': config.bench = optarg; break;
+        case 'L':
+            config.log_mode = LOG_BUFFERED;
+            if (strcmp(optarg, "latency") == 0) config.log_flush = LOG_FLUSH_CYCLE;
+            else if (strcmp(optarg, "throughput") == 0) config.log_flush = LOG_FLUSH_FULL;
+            else if ((config.log_flush = atoi(optarg)) <= 0) { usage(argv[0]); exit(EXIT_FAILURE); }
+            break;
+        case 'f': config.log_file = optarg; break;
+        case 'E': config.event_log = optarg; break;
+        case 'G': config.timeline = optarg; break;
+        case 'R': config.results = optarg; break;
+        case 'T': config.run_tag = optarg; break;
+        case 'N': config.sample_one_in = atoi(optarg); break;
+        case 'W': config.tail_wait_sec = atof(optarg) / 1000.0; break;
+        case 'V': config.reservoir_size = atoi(optarg); break;
+        case 'Y':
+            if ((backend = sync_backend_parse(optarg)) < 0) { usage(argv[0]); exit(EXIT_FAILURE); }
+            config.sync = (sync_backend_t)backend;
+            break;
+        case 's': config.stress = true; break;
+        case 'n': config.max_cycles = strtoul(optarg, NULL, 10); break;
+        case 'X': config.chaos_percent = atoi(optarg); break;
+        case 'w': config.watchdog_ms = atoi(optarg); break;
+        case 'P': config.processes = atoi(optarg); break;
+        case 'D': config.shards = atoi(optarg); break;
+        case 'x': config.transfer_percent = atoi(optarg); break;
+        case 'F': config.barrier_fanin = atoi(optarg); break;
+        case 'p': config.params_file = optarg; break;
+        case 'Z': config.scenario_file = optarg; break;
+        case 'o': config.policy = optarg; break;
+        case 'O': config.policy_args = optarg; break;
+        case 'y':
+            if (strcmp(optarg, "semaphores") == 0) config.cycle_barrier = false;
+            else if (strcmp(optarg, "barrier") == 0) config.cycle_barrier = true;
+            else { usage(argv[0]); exit(EXIT_FAILURE); }
+            break;
+        case 'A':
+            action_given = true;
+            if (strcmp(optarg, "report") == 0) config.on_stall = STALL_REPORT;
+            else if (strcmp(optarg, "depart") == 0) config.on_stall = STALL_DEPART;
+            else if (strcmp(optarg, "shutdown") == 0) config.on_stall = STALL_SHUTDOWN;
+            else if (strcmp(optarg, "abort") == 0) config.on_stall = STALL_ABORT;
+            else { usage(argv[0]); exit(EXIT_FAILURE); }
+            break;
+        case 'C':
+            if (strcmp(optarg, "off") == 0) config.check_mode = CHECK_OFF;
+            else if (strcmp(optarg, "on") == 0) config.check_mode = CHECK_ON;
+            else if (strcmp(optarg, "heavy") == 0) config.check_mode = CHECK_HEAVY;
+            else { usage(argv[0]); exit(EXIT_FAILURE); }
+            break;
+        case 'l':
+            level_given = true;
+            if (strcmp(optarg, "none") == 0) log_level = LOG_NONE;
+            else if (strcmp(optarg, "summary") == 0) log_level = LOG_SUMMARY;
+            else if (strcmp(optarg, "phase") == 0) log_level = LOG_PHASE;
+            else if (strcmp(optarg, "event") == 0) log_level = LOG_EVENT;
+            else if (strcmp(optarg, "debug") == 0) log_level = LOG_DEBUG;
+            else { usage(argv[0]); exit(EXIT_FAILURE); }
+            if (log_level > LOG_COMPILE_LEVEL) {
+                fprintf(stderr, "Log level %s is compiled out of this build\n", optarg);
+            }
+            break;
+        case 'S':
+            if (strcmp(optarg, "write") == 0) config.log_sink = SINK_WRITE;
+            else if (strcmp(optarg, "uring") == 0) config.log_sink = SINK_URING;
+            else if (strcmp(optarg, "mmap") == 0) config.log_sink = SINK_MMAP;
+            else { usage(argv[0]); exit(EXIT_FAILURE); }
+            break;
+        case 'H':
+            if (strcmp(optarg, "normal") == 0) config.page_mode = PAGES_NORMAL;
+            else if (strcmp(optarg, "transparent") == 0) config.page_mode = PAGES_TRANSPARENT;
+            else if (strcmp(optarg, "explicit") == 0) config.page_mode = PAGES_EXPLICIT;
+            else { usage(argv[0]); exit(EXIT_FAILURE); }
+            break;
+        case 'h': usage(argv[0]); exit(EXIT_SUCCESS);
+        default:  usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+
+    // Sinks only see buffered output; pick the throughput policy unless
+    // the user chose one.
+    if ((config.log_file != NULL || config.log_sink != SINK_WRITE) &&
+        config.log_mode == LOG_STDIO) {
+        config.log_mode = LOG_BUFFERED;
+        config.log_flush = LOG_FLUSH_FULL;
+    }
+
+    // Per-event lines at stress rates would only measure the terminal.
+    if (config.stress && !level_given) log_level = LOG_SUMMARY;
+    // A stress run that stalls has found a bug; fail it unless told otherwise.
+    if (config.stress && config.watchdog_ms == 0) config.watchdog_ms = STRESS_STALL_MS;
+    if (config.stress && !action_given) config.on_stall = STALL_ABORT;
+
+    if (config.runtime_sec <= 0 || config.num_cars <= 0 ||
+        config.capacity <= 0 || config.capacity > MAX_CAPACITY ||
+        config.sample_one_in <= 0 || config.reservoir_size < 0 || config.tail_wait_sec < 0 ||
+        config.chaos_percent < 0 || config.chaos_percent > 100 || config.watchdog_ms < 0 ||
+        config.processes < 0 || config.processes > config.num_cars ||
+        config.shards < 0 || config.shards > config.num_cars ||
+        config.transfer_percent < 0 || config.transfer_percent > 100 ||
+        config.barrier_fanin < 0 || config.barrier_fanin == 1) {
+        usage(argv[0]); exit(EXIT_FAILURE);
+    }
+    total_cars = config.num_cars;
+
+    // Outputs written from the car side through per-process state cannot
+    // be merged across car processes.
+    if (config.processes > 0 &&
+        (config.event_log != NULL || config.timeline != NULL || config.reservoir_size > 0 ||
+         (config.log_mode == LOG_BUFFERED && config.log_sink != SINK_WRITE))) {
+        fprintf(stderr, "--processes does not support --event-log, --timeline, --reservoir "
+                "or the uring and mmap log sinks\n");
+        exit(EXIT_FAILURE);
+    }
+    // A forced partial departure needs the ferry to wait on sem_full; a
+    // barrier phase only completes with every seat filled.
+    if (config.cycle_barrier && config.on_stall == STALL_DEPART) {
+        fprintf(stderr, "--cycle barrier does not support --on-stall depart\n");
+        exit(EXIT_FAILURE);
+    }
+    // Shards are processes already, and would all write the same files.
+    if (config.shards > 0 &&
+        (config.processes > 0 || config.event_log != NULL || config.timeline != NULL ||
+         config.results != NULL || config.reservoir_size > 0 || config.log_file != NULL)) {
+        fprintf(stderr, "--shards does not support --processes, --event-log, --timeline, "
+                "--results, --reservoir or --log-file\n");
+        exit(EXIT_FAILURE);
+    }
+    params_defaults(&startup_params);
+    if (config.params_file != NULL && load_params_file(&startup_params) != 0) exit(EXIT_FAILURE);
+
+    if (config.scenario_file != NULL) {
+        char error[256];
+        if (scenario_compile(&scenario, config.scenario_file, config.runtime_sec, config.capacity,
+                             error, sizeof(error)) != 0) {
+            fprintf(stderr, "Scenario: %s\n", error);
+            exit(EXIT_FAILURE);
+        }
+        // Barrier phases complete with every seat filled, so the seats
+        // cannot change from one cycle to the next.
+        for (int i = 0; i < scenario.event_count && config.cycle_barrier; i++) {
+            if (scenario.events[i].kind == SCENARIO_CAPACITY_BEGIN) {
+                fprintf(stderr, "Scenario: capacity windows need --cycle semaphores\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    char policy_error[512];
+    if (policy_load(&policy, config.policy, config.policy_args, policy_error, sizeof(policy_error)) != 0) {
+        fprintf(stderr, "Policy: %s\n", policy_error);
+        exit(EXIT_FAILURE);
+    }
+    queue_boarding = policy_orders_boarding(&policy);
+    if (policy.kind != POLICY_SEMAPHORE && config.processes > 0) {
+        fprintf(stderr, "Policy: --processes supports only the semaphore policy\n");
+        exit(EXIT_FAILURE);
+    }
+    // Departing early is a partial departure, which a barrier phase cannot end.
+    if (policy_decides_departure(&policy) && config.cycle_barrier) {
+        fprintf(stderr, "Policy: %s decides departures, which needs --cycle semaphores\n",
+                policy_name(&policy));
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char* argv[]) {
     pthread_t ferry_tid;
-    pthread_t car_threads[FERRY_CAPACITY]; // Array to store thread IDs for proper cleanup
 
-    srand(time(NULL));
+    parse_args(argc, argv);
+
+    if (config.bench != NULL) {
+        if (strcmp(config.bench, "engine") == 0) run_engine_benchmark();
+        else if (strcmp(config.bench, "log") == 0) run_log_benchmark();
+        else if (strcmp(config.bench, "log-level") == 0) run_log_level_benchmark();
+        else if (strcmp(config.bench, "policy") == 0) run_policy_benchmark();
+        else { usage(argv[0]); exit(EXIT_FAILURE); }
+        return 0;
+    }
+
+    // Pick the engine once; the ferry and car threads call through it.
+    engine = select_engine(config.capacity, config.generic_engine);
+
+    unsigned int seed = (unsigned int)time(NULL);
+    srand(seed);
     gettimeofday(&start_time, NULL);
 
-    pthread_mutex_init(&car_count_mutex, NULL);
+    // A sharded run forks its shards here; this process only coordinates.
+    int shard_status;
+    if (config.shards > 0 && run_shards(seed, &shard_status)) return shard_status;
+    if (config.params_file != NULL) block_reload_signal();
+
+    // Reserve all long-lived storage up front so the running simulation
+    // never has to call the allocator. Large blocks are pre-faulted here.
+    pool_set_page_mode(config.page_mode);
+    pthread_t* car_threads = counted_malloc(sizeof(pthread_t) * config.num_cars);
+    car_agent_t** car_agents = counted_malloc(sizeof(car_agent_t*) * config.num_cars);
+    pid_t* car_pids = counted_malloc(sizeof(pid_t) * (config.processes + 1));
+    if (car_threads == NULL || car_agents == NULL || car_pids == NULL ||
+        pool_init(&car_pool, sizeof(car_agent_t), config.num_cars) != 0 ||
+        dock_create() != 0 || policy_reserve() != 0 || (shard_index >= 0 && shard_reserve() != 0) ||
+        log_init(config.log_mode, config.log_flush, config.num_cars + 1,
+                 config.log_sink, config.log_file) != 0) {
+        perror("Failed to reserve simulation storage"); exit(EXIT_FAILURE);
+    }
+    track_journeys = config.tail_wait_sec > 0 || config.reservoir_size > 0 ||
+                     config.timeline != NULL;
+    if (config.reservoir_size > 0 &&
+        (reservoir = counted_malloc(sizeof(journey_t) * config.reservoir_size)) == NULL) {
+        perror("Failed to reserve journey reservoir"); exit(EXIT_FAILURE);
+    }
+    if (config.event_log != NULL && evlog_open(config.event_log) != 0) {
+        perror("Failed to open event log"); exit(EXIT_FAILURE);
+    }
+    // Lane 0 is the ferry, lane s + 1 is seat s.
+    if (config.timeline != NULL && timeline_open(config.timeline, config.capacity + 1) != 0) {
+        perror("Failed to open timeline"); exit(EXIT_FAILURE);
+    }
+    unsigned long startup_alloc_calls = allocator_calls();
+    unsigned long startup_map_calls = mapping_calls();
+
+    int dtlb_miss_fd = open_dtlb_counter(true);
+    int dtlb_access_fd = open_dtlb_counter(false);
 
     // Initialize named semaphores. 
     // We unlink first to clean up any potential leftovers from previous runs.
-    sem_unlink("/sem_board"); sem_unlink("/sem_full");
-    sem_unlink("/sem_unboard"); sem_unlink("/sem_empty");
+    // Car processes need process-shared ones; every shard needs its own names.
+    int pshared = config.processes > 0;
+    char names[4][SYNC_NAME_LEN];
+    const char* roles[4] = { "board", "full", "unboard", "empty" };
+    for (int i = 0; i < 4; i++) {
+        if (shard_index >= 0) snprintf(names[i], SYNC_NAME_LEN, "/sem_%s.%d", roles[i], shard_index);
+        else snprintf(names[i], SYNC_NAME_LEN, "/sem_%s", roles[i]);
+    }
+    if (sync_init(&dock->sem_board, config.sync, names[0], pshared) != 0 ||
+        sync_init(&dock->sem_full, config.sync, names[1], pshared) != 0 ||
+        sync_init(&dock->sem_unboard, config.sync, names[2], pshared) != 0 ||
+        sync_init(&dock->sem_empty, config.sync, names[3], pshared) != 0) {
+        fprintf(stderr, "Failed to create %s semaphores\n", sync_backend_name(config.sync));
+        exit(EXIT_FAILURE);
+    }
 
-    // O_CREAT creates the semaphore if it doesn't exist.
-    // 0644 gives read/write permissions to the owner.
-    sem_board = sem_open("/sem_board", O_CREAT, 0644, 0);
-    sem_full = sem_open("/sem_full", O_CREAT, 0644, 0);
-    sem_unboard = sem_open("/sem_unboard", O_CREAT, 0644, 0);
-    sem_empty = sem_open("/sem_empty", O_CREAT, 0644, 0);
+    // Car processes are forked while this process has a single thread, so
+    // no lock can be copied in a held state.
+    if (config.processes > 0) start_car_processes(car_pids, seed);
+    if (shard_index >= 0) shard_start();
 
-    if (sem_board == SEM_FAILED) { perror("sem_open failed"); exit(EXIT_FAILURE); }
+    // The file is watched from before the first car starts.
+    if (config.params_file != NULL && pthread_create(&reload_tid, NULL, reload_thread, NULL) != 0) {
+        perror("Failed to create parameter reload thread"); exit(EXIT_FAILURE);
+    }
 
     // Create the Ferry Thread
     if (pthread_create(&ferry_tid, NULL, ferry_thread, NULL) != 0) {
         perror("Failed to create ferry thread"); exit(EXIT_FAILURE);
     }
 
-    // Create Car Threads (Exactly 5 cars as per capacity)
-    for (int i = 0; i < FERRY_CAPACITY; i++) {
-        usleep((rand() % 999000) + 1000); // Random delay before creating each car
-
-        int* car_id = (int*)malloc(sizeof(int));
-        *car_id = i + 1; // Assign ID from 1 to 5
-
-        if (pthread_create(&car_threads[i], NULL, car_thread, car_id) != 0) {
-            perror("Failed to create car thread"); exit(EXIT_FAILURE);
+    // Create Car Threads (5 cars, matching the capacity, unless --cars is
+    // given). Car threads get small stacks so thousands of them fit.
+    if (config.processes == 0) {
+        pthread_attr_t car_attr;
+        pthread_attr_init(&car_attr);
+        pthread_attr_setstacksize(&car_attr, CAR_STACK_SIZE);
+        for (int i = 0; i < config.num_cars; i++) {
+            car_agents[i] = start_car(first_car_id + i, &car_threads[i], &car_attr); // IDs 1 to N
         }
-        
+        pthread_attr_destroy(&car_attr);
+    }
+
+    pthread_t watchdog_tid;
+    if (config.watchdog_ms > 0 && pthread_create(&watchdog_tid, NULL, watchdog_thread, NULL) != 0) {
+        perror("Failed to create watchdog thread"); exit(EXIT_FAILURE);
     }
 
     // --- MAIN EXECUTION CONTROL ---
-    // The main thread sleeps for the exact duration of the program runtime.
-    // This blocks the main thread while the simulation runs in the background.
-    sleep(PROGRAM_RUNTIME);
+    // The main thread waits for the program runtime, until the ferry has
+    // run its --cycles, or until the watchdog asks for a shutdown, while
+    // the simulation runs in the background. A shard also keeps pinging
+    // the coordinator to refine its clock offset. The departure policy's
+    // timer is checked here too, so it fires within one poll interval, and
+    // a --policy gets its tick.
+    double next_ping = 0;
+    while (!__atomic_load_n(&dock->ferry_done, __ATOMIC_ACQUIRE) &&
+           !__atomic_load_n(&dock->stop_requested, __ATOMIC_ACQUIRE) &&
+           get_relative_time_sec() < config.runtime_sec) {
+        if (shard_index >= 0 && get_relative_time_sec() >= next_ping) {
+            send_time_ping();
+            next_ping = get_relative_time_sec() + SHARD_SYNC_MS / 1000.0;
+        }
+        int depart_after_ms = params_read(&dock->params).depart_after_ms;
+        if (depart_after_ms > 0 && force_partial_departure(depart_after_ms / 1000.0)) {
+            timed_departures++;
+            LOG_STATUS(LOG_PHASE, "departs partially loaded (depart_after_ms)", -1);
+        }
+        if (policy.kind != POLICY_SEMAPHORE) {
+            lock_dock();
+            consider_departure(FERRY_POLICY_TICK, -1);
+            unlock_dock();
+        }
+        usleep(WATCHDOG_POLL_US);
+    }
+    double run_sec = get_relative_time_sec();
 
     // --- TERMINATION PHASE ---
     // The simulation time is up. We need to stop all threads safely.
@@ -214,20 +2460,143 @@ int main() {
     // Since threads are in infinite loops, we send a cancellation request first.
     pthread_cancel(ferry_tid);
     pthread_join(ferry_tid, NULL);
+    __atomic_store_n(&dock->ferry_done, 1, __ATOMIC_RELEASE);
+    if (config.watchdog_ms > 0) pthread_join(watchdog_tid, NULL);
+    if (config.params_file != NULL) pthread_join(reload_tid, NULL);
 
     // 2. Terminate and Join Car Threads
-    for (int i = 0; i < FERRY_CAPACITY; i++) {
-        pthread_cancel(car_threads[i]);
-        pthread_join(car_threads[i], NULL);
+    // Cancel them all before joining any: futex and spin waiters only
+    // notice cancellation when they poll, and those waits overlap this way.
+    // Car processes see ferry_done and stop their own threads.
+    int failed_processes = 0;
+    if (config.processes > 0) {
+        failed_processes = wait_car_processes(car_pids);
+    } else {
+        for (int i = 0; i < config.num_cars; i++) pthread_cancel(car_threads[i]);
+        for (int i = 0; i < config.num_cars; i++) pthread_join(car_threads[i], NULL);
+    }
+    if (shard_index >= 0) shard_finish(run_sec);
+
+    // Heap calls made after startup; the target in steady state is zero.
+    unsigned long run_alloc_calls = allocator_calls() - startup_alloc_calls;
+    unsigned long run_map_calls = mapping_calls() - startup_map_calls;
+
+    // Every thread has stopped, so pending log lines can be written out
+    // and the sink drained before the reports are printed.
+    log_shutdown();
+
+    // --- ALLOCATOR REPORT ---
+    print_summary("Allocator calls during run: %lu (%.2f per million events, %lu events), "
+           "%lu huge page mappings\n", run_alloc_calls,
+           dock->events_logged ? run_alloc_calls * 1e6 / dock->events_logged : 0.0,
+           dock->events_logged, run_map_calls);
+
+    // --- UTILIZATION REPORT ---
+    if (config.stress) {
+        char cars[64];
+        if (config.processes > 0) {
+            snprintf(cars, sizeof(cars), "%d cars in %d processes", config.num_cars, config.processes);
+        } else {
+            snprintf(cars, sizeof(cars), "%d car threads", config.num_cars);
+        }
+        print_summary("Stress (%s, %s, chaos %d%%): %lu departures, %lu journeys in %.2f s "
+                      "(%.0f departures/s, %.0f journeys/s)\n",
+                      sync_backend_name(config.sync), cars, config.chaos_percent,
+                      dock->departures, cars_carried, run_sec,
+                      dock->departures / run_sec, cars_carried / run_sec);
+    }
+    print_utilization();
+    if (config.params_file != NULL) {
+        print_summary("Parameters: version %lu, %lu reloads (%lu rejected), %lu timed departures\n",
+                      params_read(&dock->params).version, reloads, reloads_rejected, timed_departures);
+    }
+    if (config.scenario_file != NULL) {
+        print_summary("Scenario: %d directives, %lu of %d events applied, %.1f s in maintenance, "
+                      "%lu departures on a smaller vessel\n", scenario.directives,
+                      scenario_events_applied, scenario.event_count, maintenance_sec,
+                      small_vessel_departures);
+    }
+    if (policy.kind != POLICY_SEMAPHORE) {
+        print_summary("Policy %s: %lu boarding selections (%lu out of range), %lu early departures\n",
+                      policy_name(&policy), policy.selections, policy.bad_selections,
+                      policy.departures);
+    }
+
+    // --- INVARIANT REPORT ---
+    if (config.check_mode != CHECK_OFF) {
+        print_summary("Invariant checks (%s): %lu journeys, %lu violations\n",
+                      config.check_mode == CHECK_HEAVY ? "heavy" : "on",
+                      dock->check_unboards, dock->check_violations);
+    }
+
+    // --- MEMORY REPORT ---
+    // Run once with each --hugepages mode to compare TLB behaviour.
+    uint64_t dtlb_misses = 0, dtlb_accesses = 0;
+    bool have_misses = read_counter(dtlb_miss_fd, &dtlb_misses);
+    bool have_accesses = read_counter(dtlb_access_fd, &dtlb_accesses);
+    double elapsed = get_relative_time_sec();
+    print_summary("Pages: %s (requested %s), throughput %.1f events/s\n",
+           page_mode_name(pool_page_backing()), page_mode_name(config.page_mode),
+           dock->events_logged / elapsed);
+    if (have_misses && have_accesses && dtlb_accesses > 0) {
+        print_summary("dTLB load misses: %llu of %llu (%.4f%%)\n",
+               (unsigned long long)dtlb_misses, (unsigned long long)dtlb_accesses,
+               100.0 * dtlb_misses / dtlb_accesses);
+    } else {
+        print_summary("dTLB load misses: unavailable (perf events not permitted)\n");
+    }
+
+    // --- EVENT LOG REPORT ---
+    if (config.event_log != NULL) {
+        evlog_stats_t ev_stats;
+        evlog_close(&ev_stats);
+        print_summary("Event log: %llu events, %llu raw bytes -> %llu file bytes (ratio %.2f), "
+               "compression %.1f MB/s\n",
+               (unsigned long long)ev_stats.events, (unsigned long long)ev_stats.raw_bytes,
+               (unsigned long long)ev_stats.file_bytes,
+               ev_stats.file_bytes ? (double)ev_stats.raw_bytes / ev_stats.file_bytes : 0.0,
+               ev_stats.compress_seconds > 0 ? ev_stats.raw_bytes / ev_stats.compress_seconds / 1e6 : 0.0);
+    }
+
+    // --- JOURNEY RESERVOIR ---
+    if (config.reservoir_size > 0) {
+        unsigned long kept = journeys_seen < (unsigned long)config.reservoir_size
+                           ? journeys_seen : (unsigned long)config.reservoir_size;
+        print_summary("Journey reservoir: %lu of %lu journeys\n", kept, journeys_seen);
+        for (unsigned long i = 0; i < kept; i++) {
+            const journey_t* j = &reservoir[i];
+            print_summary("  Car %d queued %.4f boarded %.4f (waited %.4f) left %.4f\n",
+                          j->car_id, j->queued_at, j->boarded_at,
+                          j->boarded_at - j->queued_at, j->unboarded_at);
+        }
+    }
+
+    if (config.timeline != NULL) timeline_close();
+    if (config.results != NULL) append_results(seed, elapsed, run_alloc_calls);
+
+    // --- LOG OUTPUT REPORT ---
+    if (config.log_mode == LOG_BUFFERED) {
+        unsigned long writes = log_write_calls();
+        print_summary("Log writes: %lu %s system calls (%.2f per thousand events)\n", writes,
+               sink_kind_name(config.log_sink),
+               dock->events_logged ? writes * 1e3 / dock->events_logged : 0.0);
     }
 
     // --- CLEANUP ---
     // Destroy mutex and close/unlink semaphores to free system resources.
-    pthread_mutex_destroy(&car_count_mutex);
-    sem_close(sem_board); sem_unlink("/sem_board");
-    sem_close(sem_full);  sem_unlink("/sem_full");
-    sem_close(sem_unboard); sem_unlink("/sem_unboard");
-    sem_close(sem_empty); sem_unlink("/sem_empty");
+    for (int i = 0; i < config.num_cars && config.processes == 0; i++) {
+        pool_put(&car_pool, car_agents[i]);
+    }
+    pool_destroy(&car_pool);
+    counted_free(car_agents);
+    counted_free(reservoir);
+    counted_free(car_threads);
+    counted_free(car_pids);
+    unsigned long violations = dock->check_violations;
+    dock_destroy();
+    scenario_free(&scenario);
+    policy_release();
 
-    return 0;
+    // A violated invariant fails the run, so stress scripts notice it.
+    return violations > 0 || failed_processes > 0 ? EXIT_FAILURE : 0;
 }
\ No newline at end of file
@@ -0,0 +1,240 @@
+#define _GNU_SOURCE     // getopt_long under -std=c99
+
+#include <stdio.h>      // Standard Input/Output
+#include <stdlib.h>     // exit, calloc
+#include <stdbool.h>    // Boolean Type
+#include <getopt.h>     // Command-line options
+#include <stdint.h>     // INT64_MAX
+#include <string.h>     // memset
+#include <math.h>       // floor, pow, log10
+#include "timeline.h"   // Interval file reader
+
+// --- FERRY GANTT RENDERER ---
+// Renders an interval file written with `ferry_cross --timeline` as an SVG
+// Gantt chart on stdout: the ferry's phases on the top lane and one lane
+// per seat below. The file is streamed twice at most (once to find the end
+// of the run when --to is not given, once to draw), keeping only one
+// pending bar per lane, so memory does not grow with the run length.
+// Bars narrower than a pixel that start in the same pixel column are
+// merged into one, whatever their kinds: it takes the color of the kind
+// covering most of its time (grey when none covers half) and lists the
+// counts per kind in its title. A lane then holds at most about two bars
+// per pixel column, so the SVG stays bounded when hours of run fit in one
+// screen.
+
+#define DEFAULT_WIDTH 1600
+#define LANE_HEIGHT 14
+#define LABEL_WIDTH 70
+#define HEADER_HEIGHT 40
+#define AXIS_HEIGHT 24
+#define MERGE_PX 1.0    // Bars narrower than this merge per pixel column
+#define MIXED_COLOR "#969696"   // Merged bar without a majority kind
+
+static const char *kind_color[TL_KINDS] = {
+    "#c6dbef",  // boarding: ferry open but empty
+    "#fdae6b",  // waiting_full
+    "#31a354",  // crossing
+    "#de2d26",  // unboarding
+    "#756bb1"   // seat occupied
+};
+
+// Bar being extended on one lane, flushed when the next bar does not merge.
+typedef struct {
+    bool active;
+    int kind;
+    int car_id;
+    double x0, x1;
+    int64_t start_us, end_us;
+    unsigned long merged;   // Intervals drawn as this bar
+    long column;            // Pixel column of a narrow bar, -1 for a wide one
+    int64_t kind_us[TL_KINDS];          // Time per kind within the bar
+    unsigned long kind_count[TL_KINDS]; // Intervals per kind within the bar
+} pending_bar_t;
+
+static int64_t from_us = 0, to_us = INT64_MAX;
+static double px_per_us;
+static int width = DEFAULT_WIDTH;
+
+void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s [options] TIMELINE > chart.svg\n"
+            "  --from SEC    start of the rendered window (default 0)\n"
+            "  --to SEC      end of the rendered window (default end of run)\n"
+            "  --width PX    width of the time axis in pixels (default %d)\n",
+            prog, DEFAULT_WIDTH);
+}
+
+double lane_y(int lane) {
+    return HEADER_HEIGHT + lane * LANE_HEIGHT;
+}
+
+void flush_bar(int lane, pending_bar_t* bar) {
+    if (!bar->active) return;
+    double w = bar->x1 - bar->x0;
+    if (w < 0.5) w = 0.5;
+    const char* color = kind_color[bar->kind];
+    if (bar->merged > 1) {
+        int64_t total = 0;
+        int major = 0;
+        for (int k = 0; k < TL_KINDS; k++) {
+            total += bar->kind_us[k];
+            if (bar->kind_us[k] > bar->kind_us[major]) major = k;
+        }
+        color = 2 * bar->kind_us[major] > total ? kind_color[major] : MIXED_COLOR;
+    }
+    printf("<rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%d\" fill=\"%s\">",
+           LABEL_WIDTH + bar->x0, lane_y(lane) + 1, w, LANE_HEIGHT - 2, color);
+    if (bar->merged > 1) {
+        printf("<title>%lu intervals %.4f-%.4f:", bar->merged,
+               bar->start_us / 1e6, bar->end_us / 1e6);
+        for (int k = 0; k < TL_KINDS; k++) {
+            if (bar->kind_count[k] > 0) printf(" %lu %s", bar->kind_count[k], timeline_kind_name(k));
+        }
+        printf("</title></rect>\n");
+    } else if (bar->car_id >= 0) {
+        printf("<title>Car %d %.4f-%.4f (%.4f s)</title></rect>\n", bar->car_id,
+               bar->start_us / 1e6, bar->end_us / 1e6, (bar->end_us - bar->start_us) / 1e6);
+    } else {
+        printf("<title>%s %.4f-%.4f (%.4f s)</title></rect>\n", timeline_kind_name(bar->kind),
+               bar->start_us / 1e6, bar->end_us / 1e6, (bar->end_us - bar->start_us) / 1e6);
+    }
+    bar->active = false;
+}
+
+void add_interval(pending_bar_t* bar, int lane, const timeline_interval_t* iv) {
+    int64_t start = iv->start_us < from_us ? from_us : iv->start_us;
+    int64_t end = iv->start_us + iv->duration_us;
+    if (end > to_us) end = to_us;
+    double x0 = (start - from_us) * px_per_us;
+    double x1 = (end - from_us) * px_per_us;
+    long column = x1 - x0 < MERGE_PX ? (long)x0 : -1;
+
+    if (bar->active && column >= 0 && bar->column == column) {
+        if (x1 > bar->x1) bar->x1 = x1;
+        if (end > bar->end_us) bar->end_us = end;
+        bar->merged++;
+        bar->kind_us[iv->kind] += end - start;
+        bar->kind_count[iv->kind]++;
+        return;
+    }
+    flush_bar(lane, bar);
+    memset(bar->kind_us, 0, sizeof(bar->kind_us));
+    memset(bar->kind_count, 0, sizeof(bar->kind_count));
+    bar->kind_us[iv->kind] = end - start;
+    bar->kind_count[iv->kind] = 1;
+    bar->column = column;
+    bar->active = true;
+    bar->kind = iv->kind;
+    bar->car_id = iv->car_id;
+    bar->x0 = x0;
+    bar->x1 = x1;
+    bar->start_us = start;
+    bar->end_us = end;
+    bar->merged = 1;
+}
+
+// Tick spacing of 1, 2 or 5 times a power of ten, about ten ticks per axis.
+double tick_step(double span_sec) {
+    double raw = span_sec / 10;
+    double mag = pow(10, floor(log10(raw)));
+    if (raw / mag >= 5) return 5 * mag;
+    if (raw / mag >= 2) return 2 * mag;
+    return mag;
+}
+
+void print_axis(int lanes) {
+    double y = lane_y(lanes) + 4;
+    double span = (to_us - from_us) / 1e6;
+    double step = tick_step(span);
+    for (double t = ceil(from_us / 1e6 / step) * step; t <= to_us / 1e6; t += step) {
+        double x = LABEL_WIDTH + (t * 1e6 - from_us) * px_per_us;
+        printf("<line x1=\"%.1f\" y1=\"%d\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#ddd\"/>\n",
+               x, HEADER_HEIGHT, x, y);
+        printf("<text x=\"%.1f\" y=\"%.1f\" text-anchor=\"middle\">%g s</text>\n",
+               x, y + 14, t);
+    }
+}
+
+void print_legend(void) {
+    for (int k = 0; k < TL_KINDS; k++) {
+        int x = LABEL_WIDTH + k * 130;
+        printf("<rect x=\"%d\" y=\"12\" width=\"12\" height=\"12\" fill=\"%s\"/>"
+               "<text x=\"%d\" y=\"22\">%s</text>\n",
+               x, kind_color[k], x + 16, timeline_kind_name(k));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    static const struct option options[] = {
+        { "from",  required_argument, NULL, 'f' },
+        { "to",    required_argument, NULL, 't' },
+        { "width", required_argument, NULL, 'w' },
+        { "help",  no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'f': from_us = (int64_t)(atof(optarg) * 1e6); break;
+        case 't': to_us = (int64_t)(atof(optarg) * 1e6); break;
+        case 'w': width = atoi(optarg); break;
+        case 'h': usage(argv[0]); exit(EXIT_SUCCESS);
+        default:  usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (optind != argc - 1 || width <= 0) { usage(argv[0]); exit(EXIT_FAILURE); }
+
+    timeline_reader_t reader;
+    if (timeline_reader_open(&reader, argv[optind]) != 0) {
+        perror("Failed to open timeline"); exit(EXIT_FAILURE);
+    }
+
+    timeline_interval_t iv;
+    int rc;
+
+    // First pass: the end of the last interval sets the time scale.
+    if (to_us == INT64_MAX) {
+        to_us = from_us;
+        while ((rc = timeline_reader_next(&reader, &iv)) == 1) {
+            if (iv.start_us + iv.duration_us > to_us) to_us = iv.start_us + iv.duration_us;
+        }
+        if (rc < 0 || timeline_reader_rewind(&reader) != 0) {
+            fprintf(stderr, "Corrupt timeline\n"); exit(EXIT_FAILURE);
+        }
+    }
+    if (to_us <= from_us) { fprintf(stderr, "Empty time window\n"); exit(EXIT_FAILURE); }
+    px_per_us = (double)width / (to_us - from_us);
+
+    int lanes = reader.lanes;
+    pending_bar_t* bars = calloc(lanes, sizeof(pending_bar_t));
+    if (bars == NULL) { perror("Failed to allocate lanes"); exit(EXIT_FAILURE); }
+
+    printf("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%.0f\" "
+           "font-family=\"sans-serif\" font-size=\"11\">\n",
+           LABEL_WIDTH + width + 10, lane_y(lanes) + AXIS_HEIGHT);
+    print_legend();
+    print_axis(lanes);
+    for (int lane = 0; lane < lanes; lane++) {
+        if (lane == 0) printf("<text x=\"4\" y=\"%.1f\">Ferry</text>\n", lane_y(lane) + 11);
+        else printf("<text x=\"4\" y=\"%.1f\">Seat %d</text>\n", lane_y(lane) + 11, lane);
+    }
+
+    // Second pass: stream the bars inside the window.
+    unsigned long drawn = 0, read = 0;
+    while ((rc = timeline_reader_next(&reader, &iv)) == 1) {
+        read++;
+        if (iv.start_us + iv.duration_us < from_us || iv.start_us > to_us) continue;
+        add_interval(&bars[iv.lane], iv.lane, &iv);
+        drawn++;
+    }
+    for (int lane = 0; lane < lanes; lane++) flush_bar(lane, &bars[lane]);
+    printf("</svg>\n");
+
+    if (rc < 0) fprintf(stderr, "Corrupt timeline after %lu intervals\n", read);
+    fprintf(stderr, "Rendered %lu of %lu intervals on %d lanes\n", drawn, read, lanes);
+
+    free(bars);
+    timeline_reader_close(&reader);
+    return rc < 0 ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,932 @@
+#define _GNU_SOURCE     // getopt_long, CPU_SET, pthread_attr_setaffinity_np
+
+#include <stdio.h>      // Standard Input/Output
+#include <stdlib.h>     // exit, atoi, strtol, qsort, calloc
+#include <string.h>     // strtok, strdup, strcmp
+#include <stdint.h>     // uintptr_t car numbers in the queue
+#include <stdbool.h>    // Boolean Type
+#include <getopt.h>     // Command-line options
+#include <pthread.h>    // Worker threads
+#include <sched.h>      // sched_getaffinity, sched_yield
+#include <time.h>       // clock_gettime
+#include <unistd.h>     // fork
+#include <sys/mman.h>   // Shared state in process mode
+#include <sys/wait.h>   // waitpid
+#include "sync.h"       // The primitives under test
+#include "queue.h"      // Dock queues (--bench queue)
+#include "coord.h"      // Boarding coordinators (--bench boarding)
+#include "phase.h"      // Phase barriers (--bench cycle)
+
+// --- HANDOFF MICROBENCHMARKS ---
+// Times the ferry/car handoffs in isolation, for every sync backend, with
+// nothing else running: no dock mutex, no seats, no modeled delays.
+//   release   one-to-many: the ferry posts K permits and K cars each take
+//             one (the boarding and unboarding releases)
+//   gather    many-to-one: K cars each post once and the ferry waits for
+//             all K (sem_full and sem_empty)
+//   pingpong  one post and one wait in each direction between two threads
+//             (the latency of a single handoff)
+// Only the side under test goes through the backend; the other direction
+// of each round uses a plain atomic counter, so a release round does not
+// also pay for a gather. In process mode the cars are threads of a forked
+// process and the state is a shared mapping, which prices cross-process
+// wakeups against the thread mode. Results are CSV on stdout, one row per
+// benchmark, backend, K, placement and mode. The dock queue, boarding
+// coordinator and ferry cycle benchmarks (further down) have their own
+// columns and run alone.
+
+#define DEFAULT_ROUNDS 20000    // Handoffs per trial, divided among the K cars
+#define MIN_ROUNDS 200
+#define DEFAULT_TRIALS 5
+#define MAX_WORKERS 1024
+#define SPIN_BEFORE_YIELD 64
+#define DEFAULT_QUEUE_ITEMS 1000000 // Values pushed per queue trial
+#define DEFAULT_QUEUE_SIZE 1024
+#define DEFAULT_BATCH 5         // Cars a ferry boards per pop batch (its capacity)
+#define DEFAULT_BOARDINGS 1000000 // Boardings per coordinator trial
+
+typedef enum { BENCH_RELEASE, BENCH_GATHER, BENCH_PINGPONG, BENCHES } bench_kind_t;
+typedef enum { PLACE_NONE, PLACE_SAME, PLACE_SPREAD, PLACEMENTS } placement_t;
+typedef enum { MODE_THREADS, MODE_PROCESSES, MODES } run_mode_t;
+
+static const char *bench_names[BENCHES] = { "release", "gather", "pingpong" };
+static const char *placement_names[PLACEMENTS] = { "none", "same", "spread" };
+static const char *mode_names[MODES] = { "threads", "processes" };
+
+// State shared by the ferry (the main thread) and the K car threads.
+typedef struct {
+    bench_kind_t kind;
+    int k;
+    long rounds;
+    sync_sem_t to_cars;     // release permits, pingpong ping
+    sync_sem_t to_ferry;    // gather posts, pingpong pong
+    int ready;              // Cars started
+    long taken;             // Permits taken in a release benchmark
+    long generation;        // Gather round the cars may post for
+    int stop;
+} bench_state_t;
+
+typedef struct {
+    bench_state_t *state;
+} car_arg_t;
+
+// --- CPU PLACEMENT ---
+// Placements use the CPUs this process may run on, in order:
+//   none    no pinning, the scheduler decides
+//   same    the ferry and every car on the first CPU
+//   spread  the ferry on the first CPU, car i on CPU (i + 1) mod n
+static int cpus[CPU_SETSIZE];
+static int cpu_count = 0;
+
+void load_cpus(void) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_getaffinity"); exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &set)) cpus[cpu_count++] = c;
+    }
+}
+
+// CPU of agent 0 (the ferry) .. K (the last car), or -1 when not pinned.
+int placement_cpu(placement_t place, int agent) {
+    switch (place) {
+    case PLACE_SAME:   return cpus[0];
+    case PLACE_SPREAD: return cpus[agent % cpu_count];
+    default:           return -1;
+    }
+}
+
+void cpu_only(cpu_set_t *set, int cpu) {
+    CPU_ZERO(set);
+    CPU_SET(cpu, set);
+}
+
+// --- SPIN WAITS ---
+// The untimed direction of each round. Spins briefly, then yields so that
+// the thread it waits for can run on a shared core.
+void wait_until_at_least(long *value, long target) {
+    for (int spins = 0; __atomic_load_n(value, __ATOMIC_ACQUIRE) < target; spins++) {
+        if (spins < SPIN_BEFORE_YIELD) CPU_RELAX();
+        else sched_yield();
+    }
+}
+
+// --- CAR THREAD ---
+void *car(void *arg) {
+    bench_state_t *st = ((car_arg_t *)arg)->state;
+    __atomic_fetch_add(&st->ready, 1, __ATOMIC_RELEASE);
+
+    switch (st->kind) {
+    case BENCH_RELEASE:
+        for (;;) {
+            sync_wait(&st->to_cars);
+            if (__atomic_load_n(&st->stop, __ATOMIC_ACQUIRE)) break;
+            __atomic_fetch_add(&st->taken, 1, __ATOMIC_RELEASE);
+        }
+        break;
+    case BENCH_GATHER:
+        // Each car posts exactly once per generation. The ferry only opens
+        // the next generation after all K posts, so none can be missed.
+        for (long seen = 0; ; seen++) {
+            for (int spins = 0; __atomic_load_n(&st->generation, __ATOMIC_ACQUIRE) <= seen; spins++) {
+                if (__atomic_load_n(&st->stop, __ATOMIC_ACQUIRE)) return NULL;
+                if (spins < SPIN_BEFORE_YIELD) CPU_RELAX();
+                else sched_yield();
+            }
+            sync_post(&st->to_ferry);
+        }
+        break;
+    case BENCH_PINGPONG:
+        for (long r = 0; r < st->rounds; r++) {
+            sync_wait(&st->to_cars);
+            sync_post(&st->to_ferry);
+        }
+        break;
+    default:
+        break;
+    }
+    return NULL;
+}
+
+// --- CAR SIDE SETUP ---
+static pthread_t threads[MAX_WORKERS];
+static car_arg_t args[MAX_WORKERS];
+
+// Starts the K car threads, each pinned as the placement says.
+void start_cars(bench_state_t *st, placement_t place) {
+    cpu_set_t set;
+    for (int i = 0; i < st->k; i++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (placement_cpu(place, i + 1) >= 0) {
+            cpu_only(&set, placement_cpu(place, i + 1));
+            pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        }
+        args[i].state = st;
+        if (pthread_create(&threads[i], &attr, car, &args[i]) != 0) {
+            perror("Failed to create car thread"); exit(EXIT_FAILURE);
+        }
+        pthread_attr_destroy(&attr);
+    }
+}
+
+void join_cars(bench_state_t *st) {
+    for (int i = 0; i < st->k; i++) pthread_join(threads[i], NULL);
+}
+
+// --- FERRY SIDE ---
+// Runs one timed trial and returns its nanoseconds per round. Thread and
+// process creation and startup are outside the timed region.
+double run_trial(bench_kind_t kind, sync_backend_t backend, int k, placement_t place,
+                 run_mode_t mode, long rounds) {
+    bench_state_t local;
+    bench_state_t *st = &local;
+    if (mode == MODE_PROCESSES) {
+        st = mmap(NULL, sizeof(*st), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (st == MAP_FAILED) { perror("Failed to map shared state"); exit(EXIT_FAILURE); }
+    }
+    memset(st, 0, sizeof(*st));
+    st->kind = kind;
+    st->k = k;
+    st->rounds = rounds;
+    int pshared = mode == MODE_PROCESSES;
+    if (sync_init(&st->to_cars, backend, "/ferry_mb_cars", pshared) != 0 ||
+        sync_init(&st->to_ferry, backend, "/ferry_mb_ferry", pshared) != 0) {
+        if (mode == MODE_PROCESSES) munmap(st, sizeof(*st));
+        return -1.0;
+    }
+
+    // The car process is forked before the ferry pins itself, so its
+    // threads only get the placement's CPUs.
+    pid_t pid = -1;
+    if (mode == MODE_PROCESSES) {
+        fflush(stdout);
+        pid = fork();
+        if (pid < 0) { perror("Failed to fork car process"); exit(EXIT_FAILURE); }
+        if (pid == 0) {
+            start_cars(st, place);
+            join_cars(st);
+            _exit(0);
+        }
+    } else {
+        start_cars(st, place);
+    }
+
+    cpu_set_t saved, set;
+    pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved);
+    if (placement_cpu(place, 0) >= 0) {
+        cpu_only(&set, placement_cpu(place, 0));
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    while (__atomic_load_n(&st->ready, __ATOMIC_ACQUIRE) < k) sched_yield();
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    switch (kind) {
+    case BENCH_RELEASE:
+        for (long r = 0; r < rounds; r++) {
+            for (int i = 0; i < k; i++) sync_post(&st->to_cars);
+            wait_until_at_least(&st->taken, (r + 1) * k);
+        }
+        break;
+    case BENCH_GATHER:
+        for (long r = 0; r < rounds; r++) {
+            __atomic_store_n(&st->generation, r + 1, __ATOMIC_RELEASE);
+            for (int i = 0; i < k; i++) sync_wait(&st->to_ferry);
+        }
+        break;
+    case BENCH_PINGPONG:
+        for (long r = 0; r < rounds; r++) {
+            sync_post(&st->to_cars);
+            sync_wait(&st->to_ferry);
+        }
+        break;
+    default:
+        break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    __atomic_store_n(&st->stop, 1, __ATOMIC_RELEASE);
+    if (kind == BENCH_RELEASE) {
+        for (int i = 0; i < k; i++) sync_post(&st->to_cars);
+    }
+    if (mode == MODE_PROCESSES) waitpid(pid, NULL, 0);
+    else join_cars(st);
+    pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    sync_destroy(&st->to_cars);
+    sync_destroy(&st->to_ferry);
+    if (mode == MODE_PROCESSES) munmap(st, sizeof(*st));
+
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    return ns / rounds;
+}
+
+// --- DOCK QUEUE BENCHMARK ---
+// --bench queue times the dock queue instead of a handoff: P producer
+// threads (arriving cars) push `items` distinct car numbers between them
+// into one bounded queue while C consumer threads (ferries) pop boarding
+// batches of up to --batch cars. A producer facing a full queue and a
+// consumer facing an empty one spin, then yield. The consumers add up
+// what they popped, and a checksum that does not match the pushed values
+// fails the run, so a broken queue cannot produce a number.
+typedef struct {
+    dock_queue_t queue;
+    int producers;
+    int consumers;
+    int batch;
+    long items;
+    int ready;               // Threads started
+    int go;                  // Set by the main thread to start the trial
+    long popped;             // Values taken by all consumers
+    unsigned long long checksum;
+} queue_state_t;
+
+typedef struct {
+    queue_state_t *state;
+    int index;
+} queue_arg_t;
+
+static pthread_t queue_threads[MAX_WORKERS];
+static queue_arg_t queue_args[MAX_WORKERS];
+
+void spin_or_yield(int *spins) {
+    if ((*spins)++ < SPIN_BEFORE_YIELD) CPU_RELAX();
+    else sched_yield();
+}
+
+void wait_for_go(queue_state_t *st) {
+    __atomic_fetch_add(&st->ready, 1, __ATOMIC_RELEASE);
+    for (int spins = 0; !__atomic_load_n(&st->go, __ATOMIC_ACQUIRE); ) spin_or_yield(&spins);
+}
+
+void *producer(void *arg) {
+    queue_arg_t *a = arg;
+    queue_state_t *st = a->state;
+    long first = st->items * a->index / st->producers;
+    long last = st->items * (a->index + 1) / st->producers;
+    wait_for_go(st);
+    for (long v = first; v < last; v++) {
+        // Car numbers start at 1 so that no value is NULL.
+        for (int spins = 0; !queue_push(&st->queue, (void *)(uintptr_t)(v + 1)); ) {
+            spin_or_yield(&spins);
+        }
+    }
+    return NULL;
+}
+
+void *consumer(void *arg) {
+    queue_state_t *st = ((queue_arg_t *)arg)->state;
+    unsigned long long sum = 0;
+    int spins = 0;
+    wait_for_go(st);
+    while (__atomic_load_n(&st->popped, __ATOMIC_ACQUIRE) < st->items) {
+        // One boarding: up to a batch of cars, or whatever is queued.
+        int boarded = 0;
+        void *value;
+        while (boarded < st->batch && queue_pop(&st->queue, &value)) {
+            sum += (uintptr_t)value;
+            boarded++;
+        }
+        if (boarded == 0) {
+            spin_or_yield(&spins);
+            continue;
+        }
+        spins = 0;
+        __atomic_fetch_add(&st->popped, boarded, __ATOMIC_RELEASE);
+    }
+    __atomic_fetch_add(&st->checksum, sum, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Runs one timed trial and returns its nanoseconds per item. Consumers
+// are agents 0 .. C-1 of the placement and producers follow them.
+double run_queue_trial(queue_kind_t kind, int producers, int consumers, int batch,
+                       int queue_size, placement_t place, long items) {
+    queue_state_t *st = calloc(1, sizeof(*st));
+    if (st == NULL || queue_init(&st->queue, kind, queue_size) != 0) {
+        perror("Failed to create queue"); exit(EXIT_FAILURE);
+    }
+    st->producers = producers;
+    st->consumers = consumers;
+    st->batch = batch;
+    st->items = items;
+
+    int workers = consumers + producers;
+    cpu_set_t set;
+    for (int i = 0; i < workers; i++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (placement_cpu(place, i) >= 0) {
+            cpu_only(&set, placement_cpu(place, i));
+            pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        }
+        queue_args[i].state = st;
+        queue_args[i].index = i < consumers ? i : i - consumers;
+        if (pthread_create(&queue_threads[i], &attr, i < consumers ? consumer : producer,
+                           &queue_args[i]) != 0) {
+            perror("Failed to create queue thread"); exit(EXIT_FAILURE);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    while (__atomic_load_n(&st->ready, __ATOMIC_ACQUIRE) < workers) sched_yield();
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    __atomic_store_n(&st->go, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < workers; i++) pthread_join(queue_threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    // Values 1..items sum to items * (items + 1) / 2.
+    unsigned long long expected = (unsigned long long)items * (items + 1) / 2;
+    if (st->popped != items || st->checksum != expected) {
+        fprintf(stderr, "Queue %s lost or duplicated values: %ld of %ld popped, checksum %llu, "
+                "expected %llu\n", queue_kind_name(kind), st->popped, items, st->checksum, expected);
+        exit(EXIT_FAILURE);
+    }
+    queue_destroy(&st->queue);
+    free(st);
+
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    return ns / items;
+}
+
+// --- BOARDING COORDINATOR BENCHMARK ---
+// --bench boarding times the shared part of boarding (coord.h): T car
+// threads each board and, when they got a seat, unboard again, sharing
+// `ops` boardings between them. With more cars than seats some find the
+// ferry full, as on a crowded dock. Every car marks the seat it got in an
+// occupancy array, so two cars given one seat, or a load or seat left
+// over at the end, fail the run.
+typedef struct {
+    board_coord_t coord;
+    int threads;
+    long ops;
+    int ready;
+    int go;
+    int occupant[COORD_MAX_CAPACITY];  // Thread + 1 holding each seat
+    long full;               // Boardings that found the ferry full
+    int errors;
+} board_state_t;
+
+static board_state_t *board_state;
+
+void *boarding_car(void *arg) {
+    board_state_t *st = board_state;
+    int thread = ((queue_arg_t *)arg)->index;
+    long ops = st->ops * (thread + 1) / st->threads - st->ops * thread / st->threads;
+    long full = 0;
+    __atomic_fetch_add(&st->ready, 1, __ATOMIC_RELEASE);
+    for (int spins = 0; !__atomic_load_n(&st->go, __ATOMIC_ACQUIRE); ) spin_or_yield(&spins);
+    for (long i = 0; i < ops; i++) {
+        int seat = coord_board(&st->coord, thread);
+        if (seat < 0) {
+            full++;
+            continue;
+        }
+        if (__atomic_exchange_n(&st->occupant[seat], thread + 1, __ATOMIC_RELAXED) != 0) {
+            __atomic_fetch_add(&st->errors, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&st->occupant[seat], 0, __ATOMIC_RELAXED);
+        coord_unboard(&st->coord, thread, seat);
+    }
+    __atomic_fetch_add(&st->full, full, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// Runs one timed trial and returns its nanoseconds per boarding; *batch
+// receives the mean requests applied per combining pass (1 without
+// combining) and *full_share the share of boardings that found no seat.
+double run_boarding_trial(coord_kind_t kind, int threads, int capacity, placement_t place,
+                          long ops, double *batch, double *full_share) {
+    board_state_t *st = calloc(1, sizeof(*st));
+    if (st == NULL || coord_init(&st->coord, kind, capacity, threads) != 0) {
+        perror("Failed to create boarding coordinator"); exit(EXIT_FAILURE);
+    }
+    st->threads = threads;
+    st->ops = ops;
+    board_state = st;
+
+    cpu_set_t set;
+    for (int i = 0; i < threads; i++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (placement_cpu(place, i) >= 0) {
+            cpu_only(&set, placement_cpu(place, i));
+            pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        }
+        queue_args[i].index = i;
+        if (pthread_create(&queue_threads[i], &attr, boarding_car, &queue_args[i]) != 0) {
+            perror("Failed to create car thread"); exit(EXIT_FAILURE);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    while (__atomic_load_n(&st->ready, __ATOMIC_ACQUIRE) < threads) sched_yield();
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    __atomic_store_n(&st->go, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < threads; i++) pthread_join(queue_threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (st->errors > 0 || st->coord.load != 0 || st->coord.seats != 0) {
+        fprintf(stderr, "Coordinator %s broke boarding: %d double seats, load %d, seats %#llx\n",
+                coord_kind_name(kind), st->errors, st->coord.load,
+                (unsigned long long)st->coord.seats);
+        exit(EXIT_FAILURE);
+    }
+    *batch = st->coord.passes ? (double)st->coord.combined / st->coord.passes : 1.0;
+    *full_share = (double)st->full / ops;
+    coord_destroy(&st->coord);
+    free(st);
+
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    return ns / ops;
+}
+
+// --- FERRY CYCLE BENCHMARK ---
+// --bench cycle times whole ferry cycles with K cars: the ferry releases
+// K boarding permits, waits until all K boarded, lets them off and waits
+// until all K left. Boarding permits go through the backend under test in
+// both constructions; the other three handoffs are either semaphores (the
+// last car of each phase found by an atomic count, as the simulator does
+// under the dock lock) or phase barriers (flat, or a combining tree of the
+// given fan-in, arrivals indexed by the car's seat).
+typedef struct {
+    bool barrier;
+    int k;
+    long rounds;
+    sync_sem_t board, full, unboard, empty;
+    int aboard;              // Semaphore construction: cars aboard
+    phase_barrier_t boarded, landed, emptied;
+    int ready;
+} cycle_state_t;
+
+static cycle_state_t *cycle_state;
+
+void *cycle_car(void *arg) {
+    cycle_state_t *st = cycle_state;
+    int seat = ((queue_arg_t *)arg)->index;
+    __atomic_fetch_add(&st->ready, 1, __ATOMIC_RELEASE);
+    // A car waits to land after boarding, so each of the K cars boards
+    // exactly once per cycle and its index can serve as its seat.
+    for (long r = 0; r < st->rounds; r++) {
+        sync_wait(&st->board);
+        if (st->barrier) {
+            unsigned int landed = phase_generation(&st->landed);
+            phase_arrive(&st->boarded, seat);
+            phase_wait(&st->landed, landed);
+            phase_arrive(&st->emptied, seat);
+        } else {
+            if (__atomic_add_fetch(&st->aboard, 1, __ATOMIC_ACQ_REL) == st->k) sync_post(&st->full);
+            sync_wait(&st->unboard);
+            if (__atomic_sub_fetch(&st->aboard, 1, __ATOMIC_ACQ_REL) == 0) sync_post(&st->empty);
+        }
+    }
+    return NULL;
+}
+
+// Runs one timed trial and returns its nanoseconds per cycle; -1 when the
+// backend is unavailable. fanin < 0 selects the semaphore construction.
+double run_cycle_trial(sync_backend_t backend, int fanin, int k, placement_t place, long rounds) {
+    cycle_state_t *st = calloc(1, sizeof(*st));
+    if (st == NULL) { perror("Failed to allocate cycle state"); exit(EXIT_FAILURE); }
+    st->barrier = fanin >= 0;
+    st->k = k;
+    st->rounds = rounds;
+    if (sync_init(&st->board, backend, "/ferry_mb_board", 0) != 0 ||
+        sync_init(&st->full, backend, "/ferry_mb_full", 0) != 0 ||
+        sync_init(&st->unboard, backend, "/ferry_mb_unboard", 0) != 0 ||
+        sync_init(&st->empty, backend, "/ferry_mb_empty", 0) != 0) {
+        free(st);
+        return -1.0;
+    }
+    if (st->barrier &&
+        (phase_init(&st->boarded, k, fanin, 0) != 0 || phase_init(&st->landed, k, 0, 0) != 0 ||
+         phase_init(&st->emptied, k, fanin, 0) != 0)) {
+        fprintf(stderr, "Fan-in %d cannot cover %d cars\n", fanin, k);
+        exit(EXIT_FAILURE);
+    }
+    cycle_state = st;
+
+    cpu_set_t set, saved;
+    for (int i = 0; i < k; i++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (placement_cpu(place, i + 1) >= 0) {
+            cpu_only(&set, placement_cpu(place, i + 1));
+            pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        }
+        queue_args[i].index = i;
+        if (pthread_create(&queue_threads[i], &attr, cycle_car, &queue_args[i]) != 0) {
+            perror("Failed to create car thread"); exit(EXIT_FAILURE);
+        }
+        pthread_attr_destroy(&attr);
+    }
+    pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved);
+    if (placement_cpu(place, 0) >= 0) {
+        cpu_only(&set, placement_cpu(place, 0));
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    while (__atomic_load_n(&st->ready, __ATOMIC_ACQUIRE) < k) sched_yield();
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long r = 0; r < rounds; r++) {
+        unsigned int boarded = phase_generation(&st->boarded);
+        for (int i = 0; i < k; i++) sync_post(&st->board);
+        if (st->barrier) phase_wait(&st->boarded, boarded);
+        else sync_wait(&st->full);
+
+        unsigned int emptied = phase_generation(&st->emptied);
+        if (st->barrier) {
+            phase_release(&st->landed);
+            phase_wait(&st->emptied, emptied);
+        } else {
+            for (int i = 0; i < k; i++) sync_post(&st->unboard);
+            sync_wait(&st->empty);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for (int i = 0; i < k; i++) pthread_join(queue_threads[i], NULL);
+    pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    sync_destroy(&st->board);
+    sync_destroy(&st->full);
+    sync_destroy(&st->unboard);
+    sync_destroy(&st->empty);
+    free(st);
+
+    double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+    return ns / rounds;
+}
+
+int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// --- COMMAND LINE ---
+void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] > results.csv\n"
+            "  --bench LIST      release, gather, pingpong (default all), or one of\n"
+            "                    queue, boarding or cycle alone\n"
+            "  --sync LIST       named, unnamed, condvar, futex, spin, eventfd (default all)\n"
+            "  --k LIST          cars per release or gather round (default 1,2,4,8,16,64)\n"
+            "  --placement LIST  none, same, spread (default all)\n"
+            "  --mode LIST       threads, processes (default all)\n"
+            "  --rounds N        handoffs per trial, split among the K cars (default %d)\n"
+            "  --trials N        timed trials per row (default %d)\n"
+            "Dock queue benchmark (--bench queue):\n"
+            "  --queue LIST      vyukov, mutex (default all)\n"
+            "  --producers LIST  car threads pushing (default 1,4,16,64)\n"
+            "  --consumers LIST  ferry threads popping (default 1,2,4)\n"
+            "  --batch N         cars popped per boarding (default %d)\n"
+            "  --queue-size N    queue capacity, rounded up to a power of two (default %d)\n"
+            "  --items N         values pushed per trial (default %d)\n"
+            "Boarding coordinator benchmark (--bench boarding):\n"
+            "  --coordinator LIST  mutex, atomic, combining (default all)\n"
+            "  --threads LIST    car threads boarding (default 1,4,16,64)\n"
+            "  --capacity N      seats, 1..%d (default %d)\n"
+            "  --boardings N     boardings per trial (default %d)\n"
+            "Ferry cycle benchmark (--bench cycle, also takes --sync, --k, --placement,\n"
+            "--rounds and --trials; --k defaults to 5,25,100,250,500):\n"
+            "  --fanin LIST      barrier tree fan-ins, 0 = one counter (default 0,4)\n"
+            "Lists are comma-separated.\n",
+            prog, DEFAULT_ROUNDS, DEFAULT_TRIALS, DEFAULT_BATCH, DEFAULT_QUEUE_SIZE,
+            DEFAULT_QUEUE_ITEMS, COORD_MAX_CAPACITY, DEFAULT_BATCH, DEFAULT_BOARDINGS);
+}
+
+// Parses a comma-separated list of names into a bit mask; -1 on an unknown name.
+int parse_names(char *list, const char **names, int count) {
+    int mask = 0;
+    for (char *tok = strtok(list, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        int i = 0;
+        while (i < count && strcmp(tok, names[i]) != 0) i++;
+        if (i == count) return -1;
+        mask |= 1 << i;
+    }
+    return mask;
+}
+
+// Parses a comma-separated list of integers in 1..max; the count, or -1.
+int parse_ints(char *list, int *out, int capacity, int max) {
+    int count = 0;
+    for (char *tok = strtok(list, ","); tok != NULL && count < capacity; tok = strtok(NULL, ",")) {
+        out[count] = atoi(tok);
+        if (out[count] < 1 || out[count] > max) return -1;
+        count++;
+    }
+    return count;
+}
+
+// Sweeps queue kinds, placements, producers and consumers; one CSV row each.
+void run_queue_benchmark(int queue_mask, int place_mask, const int *producers, int producer_count,
+                         const int *consumers, int consumer_count, int batch, int queue_size,
+                         long items, int trials) {
+    printf("bench,queue,producers,consumers,batch,queue_size,placement,cpus,items,trials,"
+           "ns_per_item_median,ns_per_item_min,ns_per_item_max,mitems_per_sec\n");
+    double results[trials];
+    for (int q = 0; q < QUEUE_KINDS; q++) {
+        if (!(queue_mask & (1 << q))) continue;
+        for (int p = 0; p < PLACEMENTS; p++) {
+            if (!(place_mask & (1 << p))) continue;
+            for (int pi = 0; pi < producer_count; pi++) {
+                for (int ci = 0; ci < consumer_count; ci++) {
+                    int np = producers[pi], nc = consumers[ci];
+                    if (np + nc > MAX_WORKERS) continue;
+                    // Untimed warmup, as for the handoffs.
+                    run_queue_trial(q, np, nc, batch, queue_size, p, items / 10 + 1);
+                    for (int t = 0; t < trials; t++) {
+                        results[t] = run_queue_trial(q, np, nc, batch, queue_size, p, items);
+                    }
+                    qsort(results, trials, sizeof(double), compare_double);
+                    double median = results[trials / 2];
+                    printf("queue,%s,%d,%d,%d,%d,%s,%d,%ld,%d,%.1f,%.1f,%.1f,%.2f\n",
+                           queue_kind_name(q), np, nc, batch, queue_size, placement_names[p],
+                           cpu_count, items, trials, median, results[0], results[trials - 1],
+                           1e3 / median);
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+}
+
+// Sweeps coordinators, placements and thread counts; one CSV row each.
+void run_boarding_benchmark(int coord_mask, int place_mask, const int *threads, int thread_count,
+                            int capacity, long ops, int trials) {
+    printf("bench,coordinator,threads,capacity,placement,cpus,boardings,trials,"
+           "ns_per_boarding_median,ns_per_boarding_min,ns_per_boarding_max,"
+           "mboardings_per_sec,full_share,combine_batch\n");
+    double results[trials];
+    for (int c = 0; c < COORD_KINDS; c++) {
+        if (!(coord_mask & (1 << c))) continue;
+        for (int p = 0; p < PLACEMENTS; p++) {
+            if (!(place_mask & (1 << p))) continue;
+            for (int ti = 0; ti < thread_count; ti++) {
+                int nt = threads[ti];
+                double batch = 0, full = 0, trial_batch, trial_full;
+                run_boarding_trial(c, nt, capacity, p, ops / 10 + 1, &trial_batch, &trial_full);
+                for (int t = 0; t < trials; t++) {
+                    results[t] = run_boarding_trial(c, nt, capacity, p, ops, &trial_batch, &trial_full);
+                    batch += trial_batch;
+                    full += trial_full;
+                }
+                qsort(results, trials, sizeof(double), compare_double);
+                double median = results[trials / 2];
+                printf("boarding,%s,%d,%d,%s,%d,%ld,%d,%.1f,%.1f,%.1f,%.2f,%.3f,%.2f\n",
+                       coord_kind_name(c), nt, capacity, placement_names[p], cpu_count, ops,
+                       trials, median, results[0], results[trials - 1], 1e3 / median,
+                       full / trials, batch / trials);
+                fflush(stdout);
+            }
+        }
+    }
+}
+
+// Sweeps backends, placements and K; for each, one row for the semaphore
+// construction and one per barrier fan-in.
+void run_cycle_benchmark(int backend_mask, int place_mask, const int *ks, int k_count,
+                         const int *fanins, int fanin_count, long rounds, int trials) {
+    printf("bench,construction,backend,k,fanin,placement,cpus,rounds,trials,"
+           "ns_per_cycle_median,ns_per_cycle_min,ns_per_cycle_max,ns_per_car\n");
+    double results[trials];
+    for (int s = 0; s < SYNC_BACKENDS; s++) {
+        if (!(backend_mask & (1 << s))) continue;
+        for (int p = 0; p < PLACEMENTS; p++) {
+            if (!(place_mask & (1 << p))) continue;
+            for (int ki = 0; ki < k_count; ki++) {
+                int k = ks[ki];
+                long trial_rounds = rounds / k < MIN_ROUNDS ? MIN_ROUNDS : rounds / k;
+                // Construction -1 is the semaphores, then each fan-in.
+                for (int f = -1; f < fanin_count; f++) {
+                    int fanin = f < 0 ? -1 : fanins[f];
+                    if (run_cycle_trial(s, fanin, k, p, trial_rounds / 10 + 1) < 0) {
+                        fprintf(stderr, "Backend %s unavailable, skipped\n", sync_backend_name(s));
+                        break;
+                    }
+                    for (int t = 0; t < trials; t++) {
+                        results[t] = run_cycle_trial(s, fanin, k, p, trial_rounds);
+                    }
+                    qsort(results, trials, sizeof(double), compare_double);
+                    double median = results[trials / 2];
+                    printf("cycle,%s,%s,%d,%d,%s,%d,%ld,%d,%.1f,%.1f,%.1f,%.1f\n",
+                           fanin < 0 ? "semaphores" : "barrier", sync_backend_name(s), k,
+                           fanin < 0 ? 0 : fanin, placement_names[p], cpu_count, trial_rounds,
+                           trials, median, results[0], results[trials - 1], median / k);
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static const struct option options[] = {
+        { "bench",     required_argument, NULL, 'b' },
+        { "sync",      required_argument, NULL, 's' },
+        { "k",         required_argument, NULL, 'k' },
+        { "placement", required_argument, NULL, 'p' },
+        { "mode",      required_argument, NULL, 'm' },
+        { "rounds",    required_argument, NULL, 'r' },
+        { "trials",    required_argument, NULL, 't' },
+        { "queue",     required_argument, NULL, 'q' },
+        { "producers", required_argument, NULL, 'P' },
+        { "consumers", required_argument, NULL, 'C' },
+        { "batch",     required_argument, NULL, 'B' },
+        { "queue-size", required_argument, NULL, 'Q' },
+        { "items",     required_argument, NULL, 'i' },
+        { "coordinator", required_argument, NULL, 'c' },
+        { "threads",   required_argument, NULL, 'T' },
+        { "capacity",  required_argument, NULL, 'K' },
+        { "boardings", required_argument, NULL, 'o' },
+        { "fanin",     required_argument, NULL, 'f' },
+        { "help",      no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    static const char *backend_names[SYNC_BACKENDS];
+    for (int b = 0; b < SYNC_BACKENDS; b++) backend_names[b] = sync_backend_name(b);
+    static const char *queue_names[QUEUE_KINDS];
+    for (int q = 0; q < QUEUE_KINDS; q++) queue_names[q] = queue_kind_name(q);
+    static const char *coord_names[COORD_KINDS];
+    for (int c = 0; c < COORD_KINDS; c++) coord_names[c] = coord_kind_name(c);
+
+    int bench_mask = (1 << BENCHES) - 1;
+    int backend_mask = (1 << SYNC_BACKENDS) - 1;
+    int place_mask = (1 << PLACEMENTS) - 1;
+    int mode_mask = (1 << MODES) - 1;
+    int ks[64] = { 1, 2, 4, 8, 16, 64 };
+    int k_count = 6;
+    long rounds = DEFAULT_ROUNDS;
+    int trials = DEFAULT_TRIALS;
+    bool queue_bench = false;
+    int queue_mask = (1 << QUEUE_KINDS) - 1;
+    int producers[64] = { 1, 4, 16, 64 }, consumers[64] = { 1, 2, 4 };
+    int producer_count = 4, consumer_count = 3;
+    int batch = DEFAULT_BATCH, queue_size = DEFAULT_QUEUE_SIZE;
+    long items = DEFAULT_QUEUE_ITEMS;
+    bool boarding_bench = false;
+    int coord_mask = (1 << COORD_KINDS) - 1;
+    int threads[64] = { 1, 4, 16, 64 };
+    int thread_count = 4;
+    int capacity = DEFAULT_BATCH;
+    long boardings = DEFAULT_BOARDINGS;
+    bool cycle_bench = false, k_given = false;
+    int fanins[64] = { 0, 4 };
+    int fanin_count = 2;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            if (strcmp(optarg, "queue") == 0) queue_bench = true;
+            else if (strcmp(optarg, "boarding") == 0) boarding_bench = true;
+            else if (strcmp(optarg, "cycle") == 0) cycle_bench = true;
+            else bench_mask = parse_names(optarg, bench_names, BENCHES);
+            break;
+        case 's': backend_mask = parse_names(optarg, backend_names, SYNC_BACKENDS); break;
+        case 'p': place_mask = parse_names(optarg, placement_names, PLACEMENTS); break;
+        case 'm': mode_mask = parse_names(optarg, mode_names, MODES); break;
+        case 'k':
+            k_given = true;
+            k_count = parse_ints(optarg, ks, 64, MAX_WORKERS - 1);
+            break;
+        case 'f':
+            // Fan-in 0 is the flat barrier, so parse from 0 upwards.
+            fanin_count = 0;
+            for (char *tok = strtok(optarg, ","); tok != NULL && fanin_count < 64; tok = strtok(NULL, ",")) {
+                fanins[fanin_count] = atoi(tok);
+                if (fanins[fanin_count] < 0 || fanins[fanin_count] == 1) { usage(argv[0]); exit(EXIT_FAILURE); }
+                fanin_count++;
+            }
+            break;
+        case 'q': queue_mask = parse_names(optarg, queue_names, QUEUE_KINDS); break;
+        case 'P': producer_count = parse_ints(optarg, producers, 64, MAX_WORKERS - 1); break;
+        case 'C': consumer_count = parse_ints(optarg, consumers, 64, MAX_WORKERS - 1); break;
+        case 'B': batch = atoi(optarg); break;
+        case 'Q': queue_size = atoi(optarg); break;
+        case 'i': items = strtol(optarg, NULL, 10); break;
+        case 'c': coord_mask = parse_names(optarg, coord_names, COORD_KINDS); break;
+        case 'T': thread_count = parse_ints(optarg, threads, 64, MAX_WORKERS); break;
+        case 'K': capacity = atoi(optarg); break;
+        case 'o': boardings = strtol(optarg, NULL, 10); break;
+        case 'r': rounds = strtol(optarg, NULL, 10); break;
+        case 't': trials = atoi(optarg); break;
+        case 'h': usage(argv[0]); exit(EXIT_SUCCESS);
+        default:  usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (bench_mask <= 0 || backend_mask <= 0 || place_mask <= 0 || mode_mask <= 0 || k_count <= 0 ||
+        rounds <= 0 || trials <= 0 || queue_mask <= 0 || producer_count <= 0 ||
+        consumer_count <= 0 || batch <= 0 || queue_size <= 0 || items <= 0 ||
+        coord_mask <= 0 || thread_count <= 0 || capacity < 1 || capacity > COORD_MAX_CAPACITY ||
+        boardings <= 0 || fanin_count <= 0 || optind != argc) {
+        usage(argv[0]); exit(EXIT_FAILURE);
+    }
+    load_cpus();
+
+    if (queue_bench) {
+        run_queue_benchmark(queue_mask, place_mask, producers, producer_count, consumers,
+                            consumer_count, batch, queue_size, items, trials);
+        return 0;
+    }
+    if (cycle_bench) {
+        static const int cycle_ks[] = { 5, 25, 100, 250, 500 };
+        if (!k_given) {
+            k_count = sizeof(cycle_ks) / sizeof(cycle_ks[0]);
+            memcpy(ks, cycle_ks, sizeof(cycle_ks));
+        }
+        run_cycle_benchmark(backend_mask, place_mask, ks, k_count, fanins, fanin_count,
+                            rounds, trials);
+        return 0;
+    }
+    if (boarding_bench) {
+        run_boarding_benchmark(coord_mask, place_mask, threads, thread_count, capacity,
+                               boardings, trials);
+        return 0;
+    }
+
+    printf("bench,backend,k,placement,mode,cpus,rounds,trials,"
+           "ns_per_round_median,ns_per_round_min,ns_per_round_max,ns_per_handoff\n");
+    double results[trials];
+    for (int b = 0; b < BENCHES; b++) {
+        if (!(bench_mask & (1 << b))) continue;
+        for (int s = 0; s < SYNC_BACKENDS; s++) {
+            if (!(backend_mask & (1 << s))) continue;
+            for (int p = 0; p < PLACEMENTS; p++) {
+                if (!(place_mask & (1 << p))) continue;
+                for (int m = 0; m < MODES; m++) {
+                    if (!(mode_mask & (1 << m))) continue;
+                    // Ping-pong is always one car; the K list does not apply.
+                    for (int ki = 0; ki < (b == BENCH_PINGPONG ? 1 : k_count); ki++) {
+                        int k = b == BENCH_PINGPONG ? 1 : ks[ki];
+                        long trial_rounds = rounds / k < MIN_ROUNDS ? MIN_ROUNDS : rounds / k;
+
+                        // Untimed warmup faults in the stacks and settles the scheduler.
+                        if (run_trial(b, s, k, p, m, trial_rounds / 10 + 1) < 0) {
+                            fprintf(stderr, "Backend %s unavailable, skipped\n", sync_backend_name(s));
+                            break;
+                        }
+                        for (int t = 0; t < trials; t++) {
+                            results[t] = run_trial(b, s, k, p, m, trial_rounds);
+                        }
+                        qsort(results, trials, sizeof(double), compare_double);
+
+                        // A pingpong round is two handoffs, a release or gather round is K.
+                        double median = results[trials / 2];
+                        int handoffs = b == BENCH_PINGPONG ? 2 : k;
+                        printf("%s,%s,%d,%s,%s,%d,%ld,%d,%.1f,%.1f,%.1f,%.1f\n",
+                               bench_names[b], sync_backend_name(s), k, placement_names[p],
+                               mode_names[m], cpu_count, trial_rounds, trials, median,
+                               results[0], results[trials - 1], median / handoffs);
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
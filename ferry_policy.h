@@ -0,0 +1,73 @@
+#ifndef FERRY_POLICY_H
+#define FERRY_POLICY_H
+
+// --- POLICY PLUGIN INTERFACE ---
+// The stable C interface for departure and boarding policies. A policy is
+// a table of callbacks; a shared object exports it through one function
+//
+//     const ferry_policy_t *ferry_policy(void);
+//
+// and is loaded with --policy PATH. This header is all a plugin needs: it
+// depends on no other simulator header, and fields are only ever added at
+// the end, with FERRY_POLICY_ABI_VERSION raised, so a plugin built against
+// an older version keeps loading.
+//
+// Every callback runs with the dock lock held, so a policy needs no
+// locking of its own, but it must return quickly: every car waits on that
+// lock. The view is a snapshot valid for the duration of the call.
+#define FERRY_POLICY_ABI_VERSION 1
+#define FERRY_POLICY_ENTRY "ferry_policy"
+
+typedef enum {
+    FERRY_POLICY_BOARDING = 1,   // The ferry opened boarding for a new cycle
+    FERRY_POLICY_QUEUED,         // car_id joined the boarding queue
+    FERRY_POLICY_BOARDED,        // car_id boarded
+    FERRY_POLICY_TICK            // Periodic, every 100 ms while boarding
+} ferry_policy_event_t;
+
+// What a policy sees of the dock.
+typedef struct {
+    double now;                  // Seconds since the start of the run
+    int capacity;                // Seats offered this cycle
+    int aboard;                  // Cars aboard
+    int queued;                  // Cars in the boarding queue, -1 when the
+                                 // policy does not order boarding
+    double first_board_at;       // When the first car of the cycle boarded, -1 before
+    unsigned long departures;    // Crossings so far
+    int car_id;                  // Car of a QUEUED or BOARDED event, else -1
+} ferry_dock_view_t;
+
+// One car in the boarding queue, oldest first.
+typedef struct {
+    int car_id;
+    double queued_at;            // Seconds since the start of the run
+} ferry_waiting_car_t;
+
+typedef struct {
+    int abi_version;             // FERRY_POLICY_ABI_VERSION the plugin was built for
+    const char *name;
+
+    // Optional. args is the --policy-args string ("" when none); the
+    // returned state is passed to every other callback.
+    void *(*create)(const char *args);
+    void (*destroy)(void *state);
+
+    // Optional. Told about every change of the dock listed above.
+    void (*on_state_change)(void *state, const ferry_dock_view_t *view,
+                            ferry_policy_event_t event);
+
+    // Optional. Asked after every boarding and tick while the ferry is
+    // partly loaded; nonzero sends it off with the cars aboard. Without
+    // it the ferry waits until full.
+    int (*decide_depart)(void *state, const ferry_dock_view_t *view);
+
+    // Optional. Picks which of the count waiting cars gets the next seat,
+    // as an index into waiting. Without it cars board in whatever order
+    // the boarding semaphore wakes them.
+    int (*select_next)(void *state, const ferry_dock_view_t *view,
+                       const ferry_waiting_car_t *waiting, int count);
+} ferry_policy_t;
+
+typedef const ferry_policy_t *(*ferry_policy_entry_t)(void);
+
+#endif
@@ -0,0 +1,319 @@
+#define _GNU_SOURCE     // getopt_long under -std=c99
+
+#include <stdio.h>      // Standard Input/Output
+#include <stdlib.h>     // exit, strtod
+#include <string.h>     // strcmp, strtok
+#include <stdbool.h>    // Boolean Type
+#include <math.h>       // sqrt
+#include <getopt.h>     // Command-line options
+#include "results.h"    // Columnar results store
+
+// --- FERRY RESULTS TOOL ---
+// Scans, filters, diffs and compacts columnar results files written with
+// `ferry_cross --results`.
+//
+//   ferry_results scan FILE [--columns a,b] [--where EXPR]...
+//   ferry_results diff A B [--columns a,b] [--where EXPR]...
+//   ferry_results compact IN OUT
+//
+// EXPR is COLUMN OP VALUE with OP one of < <= > >= = !=, or tag=VALUE.
+
+#define MAX_FILTERS 16
+
+typedef struct {
+    char column[RESULTS_NAME_LEN];
+    char op[3];
+    double value;
+    char text[RESULTS_TAG_LEN];     // For tag filters
+} filter_t;
+
+filter_t filters[MAX_FILTERS];
+int filter_count = 0;
+const char* column_list = NULL;
+
+void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s scan FILE [--columns a,b] [--where EXPR]...\n"
+            "       %s diff A B [--columns a,b] [--where EXPR]...\n"
+            "       %s compact IN OUT\n"
+            "EXPR is COLUMN OP VALUE (OP: < <= > >= = !=), tag=VALUE or tag!=VALUE\n",
+            prog, prog, prog);
+}
+
+// The column runs up to the first operator character, so a tag value may
+// itself contain <, >, ! or =.
+void parse_filter(const char* expr, const char* prog) {
+    if (filter_count == MAX_FILTERS) { usage(prog); exit(EXIT_FAILURE); }
+    filter_t* f = &filters[filter_count];
+
+    size_t len = strcspn(expr, "<>!=");
+    const char* at = expr + len;
+    if (len == 0 || len >= RESULTS_NAME_LEN || *at == '\0' || (at[0] == '!' && at[1] != '=')) {
+        usage(prog);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(f->column, expr, len);
+    f->column[len] = '\0';
+    size_t op_len = at[0] != '=' && at[1] == '=' ? 2 : 1;
+    memcpy(f->op, at, op_len);
+    f->op[op_len] = '\0';
+    // Tags are text; only equality means anything for them.
+    if (strcmp(f->column, "tag") == 0 && strcmp(f->op, "=") != 0 && strcmp(f->op, "!=") != 0) {
+        usage(prog);
+        exit(EXIT_FAILURE);
+    }
+    const char* rhs = at + op_len;
+    strncpy(f->text, rhs, RESULTS_TAG_LEN - 1);
+    f->value = strtod(rhs, NULL);
+    filter_count++;
+}
+
+bool compare(double v, const char* op, double x) {
+    if (strcmp(op, "<") == 0) return v < x;
+    if (strcmp(op, "<=") == 0) return v <= x;
+    if (strcmp(op, ">") == 0) return v > x;
+    if (strcmp(op, ">=") == 0) return v >= x;
+    if (strcmp(op, "!=") == 0) return v != x;
+    return v == x;
+}
+
+// True when no row of the stripe can satisfy a numeric filter.
+bool stripe_excluded(const results_file_t* rf, uint32_t s) {
+    for (int i = 0; i < filter_count; i++) {
+        int c = results_column(rf, filters[i].column);
+        if (c < 0) continue;
+        double lo = rf->stripes[s].min[c], hi = rf->stripes[s].max[c], x = filters[i].value;
+        const char* op = filters[i].op;
+        if ((strcmp(op, "<") == 0 && lo >= x) || (strcmp(op, "<=") == 0 && lo > x) ||
+            (strcmp(op, ">") == 0 && hi <= x) || (strcmp(op, ">=") == 0 && hi < x) ||
+            (strcmp(op, "=") == 0 && (x < lo || x > hi))) return true;
+    }
+    return false;
+}
+
+// --- ROW ITERATION ---
+// Calls visit for every row passing the filters, with the values of the
+// selected columns. Only the filtered and selected columns are read.
+typedef void (*row_visitor_t)(const char* tag, const double* values, void* ctx);
+
+int for_each_row(const results_file_t* rf, const int* cols, int ncols,
+                 row_visitor_t visit, void* ctx) {
+    for (int i = 0; i < filter_count; i++) {
+        if (strcmp(filters[i].column, "tag") != 0 && results_column(rf, filters[i].column) < 0) {
+            fprintf(stderr, "Unknown column in filter: %s\n", filters[i].column);
+            return -1;
+        }
+    }
+
+    for (uint32_t s = 0; s < rf->stripe_count; s++) {
+        if (stripe_excluded(rf, s)) continue;
+        uint32_t rows = rf->stripes[s].rows;
+
+        double* data = malloc(sizeof(double) * rows * (ncols + filter_count));
+        char (*tags)[RESULTS_TAG_LEN] = malloc(RESULTS_TAG_LEN * rows);
+        double* row = malloc(sizeof(double) * (ncols ? ncols : 1));
+        if (data == NULL || tags == NULL || row == NULL) return -1;
+
+        int rc = results_read_tags(rf, s, tags);
+        for (int c = 0; c < ncols && rc == 0; c++) {
+            rc = results_read_column(rf, s, cols[c], data + (size_t)c * rows);
+        }
+        for (int i = 0; i < filter_count && rc == 0; i++) {
+            int c = results_column(rf, filters[i].column);
+            if (c >= 0) rc = results_read_column(rf, s, c, data + (size_t)(ncols + i) * rows);
+        }
+
+        for (uint32_t r = 0; r < rows && rc == 0; r++) {
+            bool keep = true;
+            for (int i = 0; i < filter_count && keep; i++) {
+                if (strcmp(filters[i].column, "tag") == 0) {
+                    bool eq = strcmp(tags[r], filters[i].text) == 0;
+                    keep = strcmp(filters[i].op, "!=") == 0 ? !eq : eq;
+                } else {
+                    keep = compare(data[(size_t)(ncols + i) * rows + r], filters[i].op, filters[i].value);
+                }
+            }
+            if (!keep) continue;
+            for (int c = 0; c < ncols; c++) row[c] = data[(size_t)c * rows + r];
+            visit(tags[r], row, ctx);
+        }
+
+        free(data);
+        free(tags);
+        free(row);
+        if (rc != 0) return -1;
+    }
+    return 0;
+}
+
+// Resolves --columns (default: every column) against a file's schema.
+int select_columns(const results_file_t* rf, int* cols) {
+    if (column_list == NULL) {
+        for (int c = 0; c < rf->columns; c++) cols[c] = c;
+        return rf->columns;
+    }
+
+    char buf[1024];
+    strncpy(buf, column_list, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    int n = 0;
+    for (char* name = strtok(buf, ","); name != NULL; name = strtok(NULL, ",")) {
+        int c = results_column(rf, name);
+        if (c < 0) { fprintf(stderr, "Unknown column: %s\n", name); return -1; }
+        if (n < RESULTS_MAX_COLUMNS) cols[n++] = c;
+    }
+    return n;
+}
+
+void open_or_die(results_file_t* rf, const char* path) {
+    if (results_open(rf, path) != 0) {
+        fprintf(stderr, "Failed to read results file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// --- SCAN ---
+void print_row(const char* tag, const double* values, void* ctx) {
+    int ncols = *(int*)ctx;
+    printf("%s", tag);
+    for (int c = 0; c < ncols; c++) printf(",%.15g", values[c]);
+    printf("\n");
+}
+
+int cmd_scan(const char* path) {
+    results_file_t rf;
+    int cols[RESULTS_MAX_COLUMNS];
+    open_or_die(&rf, path);
+    int ncols = select_columns(&rf, cols);
+    if (ncols < 0) return 1;
+
+    printf("tag");
+    for (int c = 0; c < ncols; c++) printf(",%s", rf.names[cols[c]]);
+    printf("\n");
+    int rc = for_each_row(&rf, cols, ncols, print_row, &ncols);
+    results_close(&rf);
+    return rc == 0 ? 0 : 1;
+}
+
+// --- DIFF ---
+typedef struct {
+    int ncols;
+    double n;
+    double sum[RESULTS_MAX_COLUMNS];
+    double sumsq[RESULTS_MAX_COLUMNS];
+} moments_t;
+
+void accumulate(const char* tag, const double* values, void* ctx) {
+    (void)tag;
+    moments_t* m = ctx;
+    m->n++;
+    for (int c = 0; c < m->ncols; c++) {
+        m->sum[c] += values[c];
+        m->sumsq[c] += values[c] * values[c];
+    }
+}
+
+double stddev(const moments_t* m, int c) {
+    if (m->n < 2) return 0.0;
+    double mean = m->sum[c] / m->n;
+    double var = (m->sumsq[c] - m->n * mean * mean) / (m->n - 1);
+    return var > 0 ? sqrt(var) : 0.0;
+}
+
+int cmd_diff(const char* path_a, const char* path_b) {
+    results_file_t a, b;
+    int cols_a[RESULTS_MAX_COLUMNS], cols_b[RESULTS_MAX_COLUMNS];
+    open_or_die(&a, path_a);
+    open_or_die(&b, path_b);
+
+    // Compare the selected columns of A that B also has.
+    int sel[RESULTS_MAX_COLUMNS];
+    int nsel = select_columns(&a, sel);
+    if (nsel < 0) return 1;
+    int ncols = 0;
+    for (int i = 0; i < nsel; i++) {
+        int cb = results_column(&b, a.names[sel[i]]);
+        if (cb < 0) continue;
+        cols_a[ncols] = sel[i];
+        cols_b[ncols] = cb;
+        ncols++;
+    }
+
+    moments_t ma = { ncols, 0, { 0 }, { 0 } }, mb = { ncols, 0, { 0 }, { 0 } };
+    if (for_each_row(&a, cols_a, ncols, accumulate, &ma) != 0 ||
+        for_each_row(&b, cols_b, ncols, accumulate, &mb) != 0) return 1;
+
+    printf("metric,runs_a,mean_a,stddev_a,runs_b,mean_b,stddev_b,delta_pct\n");
+    for (int c = 0; c < ncols; c++) {
+        double mean_a = ma.n ? ma.sum[c] / ma.n : 0.0;
+        double mean_b = mb.n ? mb.sum[c] / mb.n : 0.0;
+        printf("%s,%.0f,%.6g,%.6g,%.0f,%.6g,%.6g,", a.names[cols_a[c]],
+               ma.n, mean_a, stddev(&ma, c), mb.n, mean_b, stddev(&mb, c));
+        if (mean_a != 0.0) printf("%.2f\n", 100.0 * (mean_b - mean_a) / mean_a);
+        else printf("\n");
+    }
+    results_close(&a);
+    results_close(&b);
+    return 0;
+}
+
+// --- COMPACT ---
+int cmd_compact(const char* in, const char* out) {
+    results_file_t rf;
+    open_or_die(&rf, in);
+
+    double* values = malloc(sizeof(double) * (rf.rows ? rf.rows : 1) * rf.columns);
+    char (*tags)[RESULTS_TAG_LEN] = malloc(RESULTS_TAG_LEN * (rf.rows ? rf.rows : 1));
+    double* column = NULL;
+    if (values == NULL || tags == NULL) return 1;
+
+    uint64_t base = 0;
+    for (uint32_t s = 0; s < rf.stripe_count; s++) {
+        uint32_t rows = rf.stripes[s].rows;
+        column = realloc(column, sizeof(double) * rows);
+        if (column == NULL || results_read_tags(&rf, s, tags + base) != 0) return 1;
+        for (int c = 0; c < rf.columns; c++) {
+            if (results_read_column(&rf, s, c, column) != 0) return 1;
+            for (uint32_t r = 0; r < rows; r++) values[(base + r) * rf.columns + c] = column[r];
+        }
+        base += rows;
+    }
+
+    remove(out);
+    int rc = rf.rows == 0 ? 0 :
+             results_append(out, rf.columns, rf.names, (uint32_t)rf.rows, values, tags);
+    printf("Compacted %llu rows from %u stripes into 1\n",
+           (unsigned long long)rf.rows, rf.stripe_count);
+    free(values);
+    free(tags);
+    free(column);
+    results_close(&rf);
+    return rc == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    static const struct option options[] = {
+        { "columns", required_argument, NULL, 'c' },
+        { "where",   required_argument, NULL, 'w' },
+        { "help",    no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", options, NULL)) != -1) {
+        switch (opt) {
+        case 'c': column_list = optarg; break;
+        case 'w': parse_filter(optarg, argv[0]); break;
+        case 'h': usage(argv[0]); exit(EXIT_SUCCESS);
+        default:  usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+
+    int args = argc - optind;
+    const char* cmd = args > 0 ? argv[optind] : "";
+    if (strcmp(cmd, "scan") == 0 && args == 2) return cmd_scan(argv[optind + 1]);
+    if (strcmp(cmd, "diff") == 0 && args == 3) return cmd_diff(argv[optind + 1], argv[optind + 2]);
+    if (strcmp(cmd, "compact") == 0 && args == 3) return cmd_compact(argv[optind + 1], argv[optind + 2]);
+    usage(argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>      // fwrite for stdio mode
+#include <string.h>     // memcpy
+#include "log.h"
+#include "pool.h"       // Buffers are reserved through large_alloc
+
+// One thread's pending output.
+typedef struct {
+    size_t used;              // Bytes waiting to be written
+    unsigned long lines;      // Lines appended since the last flush
+    char data[LOG_BUFFER_SIZE];
+} log_buffer_t;
+
+int log_level = LOG_EVENT;
+
+static log_mode_t log_mode = LOG_STDIO;
+static int log_flush_every = LOG_FLUSH_CYCLE;
+
+static log_buffer_t *buffers = NULL;  // max_threads buffers in one block
+static size_t buffers_mapped = 0;     // Mapping length for large_free
+static int buffer_count = 0;          // Buffers reserved
+static int buffers_attached = 0;      // Buffers handed out so far
+
+// Buffer owned by the calling thread, NULL when it has none.
+static __thread log_buffer_t *thread_buffer = NULL;
+
+static void flush_buffer(log_buffer_t *buf) {
+    if (buf->used == 0) return;
+    sink_write(buf->data, buf->used);
+    buf->used = 0;
+    buf->lines = 0;
+}
+
+int log_init(log_mode_t mode, int flush_every, int max_threads,
+             sink_kind_t sink, const char *path) {
+    log_mode = mode;
+    log_flush_every = flush_every;
+    if (mode != LOG_BUFFERED) return 0;
+
+    // The mmap sink already takes lock-free appends straight into the file,
+    // so staging lines in per-thread buffers would only add a copy.
+    int opened = sink_open(sink, path);
+    if (opened < 0) return -1;
+    if (opened == SINK_MMAP) return 0;
+
+    buffers = large_alloc(sizeof(log_buffer_t) * max_threads, &buffers_mapped);
+    if (buffers == NULL) return -1;
+    buffer_count = max_threads;
+    for (int i = 0; i < max_threads; i++) {
+        buffers[i].used = 0;
+        buffers[i].lines = 0;
+    }
+
+    // Anything printed through stdio so far must go out before our writes.
+    fflush(stdout);
+    return 0;
+}
+
+void log_shutdown(void) {
+    log_flush_all();
+    if (log_mode == LOG_BUFFERED) sink_close();
+    large_free(buffers, buffers_mapped);
+    buffers = NULL;
+    buffer_count = 0;
+    buffers_attached = 0;
+}
+
+void log_thread_attach(void) {
+    if (log_mode != LOG_BUFFERED) return;
+    int slot = __atomic_fetch_add(&buffers_attached, 1, __ATOMIC_RELAXED);
+    if (slot < buffer_count) thread_buffer = &buffers[slot];
+}
+
+void log_line(const char *line, size_t len) {
+    log_buffer_t *buf = thread_buffer;
+    if (buf == NULL) {
+        if (log_mode == LOG_BUFFERED) sink_write(line, len);
+        else fwrite(line, 1, len, stdout);
+        return;
+    }
+
+    if (buf->used + len > LOG_BUFFER_SIZE) flush_buffer(buf);
+    if (len > LOG_BUFFER_SIZE) {
+        sink_write(line, len);
+        return;
+    }
+
+    memcpy(buf->data + buf->used, line, len);
+    buf->used += len;
+    buf->lines++;
+
+    if (log_flush_every > 0 && buf->lines >= (unsigned long)log_flush_every) {
+        flush_buffer(buf);
+    }
+}
+
+void log_cycle_end(void) {
+    if (thread_buffer != NULL && log_flush_every == LOG_FLUSH_CYCLE) {
+        flush_buffer(thread_buffer);
+    }
+}
+
+void log_flush_all(void) {
+    int attached = buffers_attached < buffer_count ? buffers_attached : buffer_count;
+    for (int i = 0; i < attached; i++) {
+        flush_buffer(&buffers[i]);
+    }
+}
+
+unsigned long log_write_calls(void) {
+    return sink_syscalls();
+}
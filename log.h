@@ -0,0 +1,67 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>     // size_t
+#include "sink.h"       // Destination of buffered output
+
+// --- LOG LEVELS ---
+// Each log statement has a level. Levels above LOG_COMPILE_LEVEL are
+// removed by the compiler (the guard is a constant false, so not even the
+// timestamp is taken); the remaining ones are filtered at runtime against
+// log_level. Build with `make LOG_LEVEL=LOG_NONE` for maximum throughput.
+#define LOG_NONE    0   // Nothing
+#define LOG_SUMMARY 1   // End-of-run reports
+#define LOG_PHASE   2   // Ferry phase changes (leaves / arrives)
+#define LOG_EVENT   3   // Car boarding and unboarding (the default)
+#define LOG_DEBUG   4   // Internal steps such as permit releases
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
+extern int log_level;   // Runtime level, LOG_EVENT unless configured
+
+#define LOG_ENABLED(level) ((level) <= LOG_COMPILE_LEVEL && (level) <= log_level)
+
+// --- LOG OUTPUT ---
+// Where formatted log lines go. In stdio mode every line is a printf-style
+// write to stdout (the original behaviour). In buffered mode each thread
+// appends lines to its own buffer and hands it to the kernel with a single
+// write() when the flush policy says so, so lines from different threads
+// can appear out of time order within a flush window.
+typedef enum {
+    LOG_STDIO,      // One stdio call per line
+    LOG_BUFFERED    // Per-thread buffers, one write() per flush
+} log_mode_t;
+
+// Flush policies for buffered mode (values <= 0), or flush every N lines.
+#define LOG_FLUSH_CYCLE 0    // "latency": flush at the end of every ferry/car cycle
+#define LOG_FLUSH_FULL (-1)  // "throughput": flush only when the buffer fills up
+
+#define LOG_BUFFER_SIZE 16384 // Bytes buffered per thread
+
+// Sets up logging. max_threads buffers are reserved up front; threads that
+// attach after they run out fall back to direct writes. Buffered output
+// goes to the given sink, on path or on stdout when path is NULL. With the
+// mmap sink no buffers are reserved and every line is appended directly.
+int log_init(log_mode_t mode, int flush_every, int max_threads,
+             sink_kind_t sink, const char *path);
+void log_shutdown(void);
+
+// Binds a per-thread buffer to the calling thread (buffered mode only).
+void log_thread_attach(void);
+
+// Emits one formatted line (including its trailing newline).
+void log_line(const char *line, size_t len);
+
+// Marks the end of the calling thread's cycle; flushes under LOG_FLUSH_CYCLE.
+void log_cycle_end(void);
+
+// Writes out every thread's pending lines. Only call once the simulation
+// threads have stopped, e.g. after they were joined.
+void log_flush_all(void);
+
+// Number of output system calls issued by buffered mode.
+unsigned long log_write_calls(void);
+
+#endif
@@ -0,0 +1,144 @@
+#define _GNU_SOURCE     // sched_yield under -std=c99
+
+#include <stdio.h>      // fopen, fgets, snprintf
+#include <stdlib.h>     // strtol
+#include <string.h>     // strchr, strcmp, memset
+#include <ctype.h>      // isspace
+#include <sched.h>      // sched_yield
+#include "params.h"
+
+#define PARAMS_LINE 256
+
+void params_defaults(scenario_params_t *p) {
+    memset(p, 0, sizeof(*p));
+    // The original assignment's delays.
+    p->board_min_us = 10000;
+    p->board_spread_us = 40000;
+    p->unboard_min_us = 5000;
+    p->unboard_spread_us = 20000;
+    p->drive_min_us = 500000;
+    p->drive_spread_us = 1000000;
+    p->crossing_us = 3000000;
+    p->depart_after_ms = 0;
+    p->version = 1;
+}
+
+void params_init(params_domain_t *d, const scenario_params_t *p) {
+    memset(d, 0, sizeof(*d));
+    d->slot[0] = *p;
+    d->current = &d->slot[0];
+}
+
+// --- READ SIDE ---
+// Sequentially consistent on the counter and the pointer: if publish saw
+// this reader's counter at zero, the reader's load of current comes after
+// the swap and finds the new slot.
+scenario_params_t params_read(params_domain_t *d) {
+    int parity = (int)(__atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST) & 1);
+    __atomic_fetch_add(&d->readers[parity], 1, __ATOMIC_SEQ_CST);
+    scenario_params_t copy = *__atomic_load_n(&d->current, __ATOMIC_SEQ_CST);
+    // Release: the copy is done before publish can see the count drop.
+    __atomic_fetch_sub(&d->readers[parity], 1, __ATOMIC_RELEASE);
+    return copy;
+}
+
+// --- WRITE SIDE ---
+void params_publish(params_domain_t *d, const scenario_params_t *p) {
+    scenario_params_t *old = d->current;
+    scenario_params_t *next = old == &d->slot[0] ? &d->slot[1] : &d->slot[0];
+    *next = *p;
+    next->version = old->version + 1;
+    __atomic_store_n(&d->current, next, __ATOMIC_SEQ_CST);
+
+    // Grace period. Each flip sends new readers to the other counter, so
+    // the one being waited on only drains.
+    for (int flip = 0; flip < 2; flip++) {
+        unsigned long epoch = __atomic_fetch_add(&d->epoch, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&d->readers[epoch & 1], __ATOMIC_ACQUIRE) > 0) {
+            d->grace_spins++;
+            sched_yield();
+        }
+    }
+}
+
+// --- PARAMETER FILE ---
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) *--end = '\0';
+    return s;
+}
+
+// Parses a non-negative millisecond count into microseconds.
+static int parse_ms(const char *s, const char **rest, long *us) {
+    char *end;
+    long ms = strtol(s, &end, 10);
+    if (end == s || ms < 0 || ms > 3600L * 1000) return -1;
+    *us = ms * 1000;
+    *rest = end;
+    return 0;
+}
+
+// MIN-MAX or a fixed N, as min and spread.
+static int parse_range(const char *s, long *min_us, long *spread_us) {
+    long lo, hi;
+    const char *rest;
+    if (parse_ms(s, &rest, &lo) != 0) return -1;
+    hi = lo;
+    while (isspace((unsigned char)*rest)) rest++;
+    if (*rest == '-' && parse_ms(rest + 1, &rest, &hi) != 0) return -1;
+    while (isspace((unsigned char)*rest)) rest++;
+    if (*rest != '\0' || hi < lo) return -1;
+    *min_us = lo;
+    *spread_us = hi - lo;
+    return 0;
+}
+
+int params_load(const char *path, scenario_params_t *p, char *error, size_t error_len) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        snprintf(error, error_len, "cannot open %s", path);
+        return -1;
+    }
+    char line[PARAMS_LINE];
+    int lineno = 0, status = 0;
+    while (status == 0 && fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash != NULL) *hash = '\0';
+        char *text = trim(line);
+        if (*text == '\0') continue;
+        char *eq = strchr(text, '=');
+        if (eq == NULL) {
+            snprintf(error, error_len, "%s:%d: expected key = value", path, lineno);
+            status = -1;
+            break;
+        }
+        *eq = '\0';
+        char *key = trim(text), *value = trim(eq + 1);
+        long fixed = 0, spread = 0;
+        const char *rest;
+        if (strcmp(key, "board_ms") == 0) {
+            status = parse_range(value, &p->board_min_us, &p->board_spread_us);
+        } else if (strcmp(key, "unboard_ms") == 0) {
+            status = parse_range(value, &p->unboard_min_us, &p->unboard_spread_us);
+        } else if (strcmp(key, "drive_ms") == 0) {
+            status = parse_range(value, &p->drive_min_us, &p->drive_spread_us);
+        } else if (strcmp(key, "crossing_ms") == 0) {
+            status = parse_range(value, &fixed, &spread);
+            if (status == 0 && spread != 0) status = -1;
+            p->crossing_us = fixed;
+        } else if (strcmp(key, "depart_after_ms") == 0) {
+            status = parse_ms(value, &rest, &fixed);
+            if (status == 0 && *rest != '\0') status = -1;
+            p->depart_after_ms = (int)(fixed / 1000);
+        } else {
+            snprintf(error, error_len, "%s:%d: unknown key %s", path, lineno, key);
+            status = -1;
+            break;
+        }
+        if (status != 0) snprintf(error, error_len, "%s:%d: bad value for %s", path, lineno, key);
+    }
+    fclose(f);
+    return status;
+}
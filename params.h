@@ -0,0 +1,64 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stddef.h>     // size_t
+
+// --- SCENARIO PARAMETERS ---
+// The modeled delays and the departure policy of a run, kept as one
+// snapshot that can be replaced while the simulation runs (--params).
+// The hot paths never see a half-updated scenario and never take a lock:
+//
+//   read     a reader registers in the counter of the current epoch
+//            parity, copies the snapshot `current` points to, and leaves
+//            the counter again. Two atomic adds and a small copy.
+//   publish  the single writer fills the slot nobody points to, swaps
+//            `current` over to it, then waits out a grace period: it
+//            flips the epoch so new readers use the other counter, waits
+//            for the old counter to drain, and does the same for the
+//            other parity. Any reader that could still be copying the old
+//            slot was counted before the swap, so once both counters have
+//            been seen at zero the old slot is free for the next publish.
+//
+// This is the counter-pair scheme of sleepable RCU; two slots suffice as
+// publish returns only after its grace period. The domain holds no
+// pointers to outside memory, so it works in the shared dock segment too,
+// where every process maps it at the same address.
+//
+// File format: one `key = value` per line, # starts a comment. Keys left
+// out take their default, so deleting a line reverts it.
+//   board_ms         boarding time, MIN-MAX or a fixed N (default 10-50)
+//   unboard_ms       unboarding time (default 5-25)
+//   drive_ms         time ashore between journeys, i.e. the arrival rate
+//                    (default 500-1500)
+//   crossing_ms      crossing time (default 3000)
+//   depart_after_ms  leave partially loaded once the first car aboard has
+//                    waited this long; 0 waits until full (default 0)
+typedef struct {
+    long board_min_us, board_spread_us;      // min + rand() % spread
+    long unboard_min_us, unboard_spread_us;
+    long drive_min_us, drive_spread_us;
+    long crossing_us;
+    int depart_after_ms;
+    unsigned long version;                   // 1 at startup, +1 per publish
+} scenario_params_t;
+
+typedef struct {
+    scenario_params_t slot[2];
+    scenario_params_t *current;              // Into slot[]
+    unsigned long epoch;                     // Parity picks the readers counter
+    long readers[2];                         // Readers inside a copy, per parity
+    unsigned long grace_spins;               // Yields publish spent waiting
+} params_domain_t;
+
+void params_defaults(scenario_params_t *p);
+void params_init(params_domain_t *d, const scenario_params_t *p);
+// Lock-free, safe from any thread or process sharing the domain.
+scenario_params_t params_read(params_domain_t *d);
+// One writer at a time. Returns once no reader can see the old snapshot.
+void params_publish(params_domain_t *d, const scenario_params_t *p);
+// Parses a parameter file over *p (which holds the defaults). Returns -1
+// with a message in error when the file cannot be read or is invalid;
+// *p is then unspecified.
+int params_load(const char *path, scenario_params_t *p, char *error, size_t error_len);
+
+#endif
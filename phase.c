@@ -0,0 +1,112 @@
+#define _GNU_SOURCE     // syscall, sched_yield under -std=c99
+
+#include <string.h>     // memset
+#include <limits.h>     // INT_MAX waiters woken
+#include <pthread.h>    // pthread_testcancel
+#include <sched.h>      // sched_yield
+#include <time.h>       // Futex wait timeout
+#ifdef __linux__
+#include <unistd.h>             // syscall
+#include <sys/syscall.h>        // SYS_futex
+#include <linux/futex.h>        // FUTEX_WAIT, FUTEX_WAKE and their _PRIVATE forms
+#endif
+#include "sync.h"       // CPU_RELAX
+#include "phase.h"
+
+// Spins before a waiter goes to sleep; a ferry cycle under --stress is
+// often shorter than a futex round trip.
+#define PHASE_SPIN_LIMIT 256
+// Longest a waiter sleeps before checking for cancellation.
+#define PHASE_CANCEL_POLL_NS (50 * 1000 * 1000)
+
+int phase_init(phase_barrier_t *b, int parties, int fanin, int pshared) {
+    memset(b, 0, sizeof(*b));
+    b->parties = parties;
+    b->fanin = fanin;
+    b->pshared = pshared;
+    if (parties < 1) parties = 1;
+    if (fanin < 2 || fanin >= parties) {
+        // One counter takes every arrival.
+        b->fanin = 0;
+        b->leaves = 1;
+        b->root = 0;
+        b->node[0].expected = b->node[0].count = parties;
+        b->node[0].parent = -1;
+        return 0;
+    }
+
+    // Build the tree level by level: each level has one node per fanin
+    // nodes (or arrivals) of the level below.
+    int first = 0, size = (parties + fanin - 1) / fanin, below = parties;
+    b->leaves = size;
+    for (;;) {
+        if (first + size > PHASE_MAX_NODES) return -1;
+        for (int i = 0; i < size; i++) {
+            phase_node_t *n = &b->node[first + i];
+            n->expected = below - i * fanin < fanin ? below - i * fanin : fanin;
+            n->count = n->expected;
+            n->parent = -1;
+        }
+        if (size == 1) break;
+        int next = first + size;
+        for (int i = 0; i < size; i++) b->node[first + i].parent = next + i / fanin;
+        below = size;
+        first = next;
+        size = (size + fanin - 1) / fanin;
+    }
+    b->root = first;
+    return 0;
+}
+
+unsigned int phase_generation(phase_barrier_t *b) {
+    return __atomic_load_n(&b->generation, __ATOMIC_ACQUIRE);
+}
+
+void phase_release(phase_barrier_t *b) {
+    // Sequentially consistent on both sides, as in the futex backend:
+    // either the waiter sees the new generation or this sees the waiter.
+    __atomic_add_fetch(&b->generation, 1, __ATOMIC_SEQ_CST);
+#ifdef __linux__
+    if (__atomic_load_n(&b->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        syscall(SYS_futex, &b->generation, b->pshared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE,
+                INT_MAX, NULL, NULL, 0);
+    }
+#endif
+}
+
+bool phase_arrive(phase_barrier_t *b, int index) {
+    int n = b->fanin ? index / b->fanin : 0;
+    for (;;) {
+        phase_node_t *node = &b->node[n];
+        // The acq_rel decrement orders every earlier arrival at this node
+        // before the one that completes it, and on up the tree.
+        if (__atomic_sub_fetch(&node->count, 1, __ATOMIC_ACQ_REL) > 0) return false;
+        // Nobody arrives here again before the generation advances.
+        __atomic_store_n(&node->count, node->expected, __ATOMIC_RELAXED);
+        if (node->parent < 0) break;
+        n = node->parent;
+    }
+    phase_release(b);
+    return true;
+}
+
+void phase_wait(phase_barrier_t *b, unsigned int seen) {
+    for (int spins = 0; spins < PHASE_SPIN_LIMIT; spins++) {
+        if (__atomic_load_n(&b->generation, __ATOMIC_ACQUIRE) != seen) return;
+        CPU_RELAX();
+    }
+    while (__atomic_load_n(&b->generation, __ATOMIC_ACQUIRE) == seen) {
+        pthread_testcancel();
+#ifdef __linux__
+        struct timespec poll = { 0, PHASE_CANCEL_POLL_NS };
+        __atomic_fetch_add(&b->sleepers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&b->generation, __ATOMIC_SEQ_CST) == seen) {
+            syscall(SYS_futex, &b->generation, b->pshared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE,
+                    seen, &poll, NULL, 0);
+        }
+        __atomic_fetch_sub(&b->sleepers, 1, __ATOMIC_SEQ_CST);
+#else
+        sched_yield();
+#endif
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef PHASE_H
+#define PHASE_H
+
+#include <stdbool.h>    // Boolean Type
+
+// --- PHASE BARRIERS ---
+// A cyclic barrier for the ferry cycle. `parties` arrivals complete a
+// phase; the last one advances the generation and wakes everyone waiting
+// on it. Waiters remember the generation they saw and sleep until it
+// changes, which is what makes the barrier reusable: the generation
+// plays the role of the sense flag of a sense-reversing barrier, and a
+// phase cannot be confused with the next one.
+//
+// The same generation can also be advanced without arrivals (release),
+// so one barrier type covers both directions of the ferry cycle:
+//   gather   every car aboard arrives, the ferry waits for the phase
+//   release  the ferry releases the phase, every car aboard wakes at once
+//
+// Arrivals either hit one counter (fanin 0) or climb a combining tree:
+// arrival i counts down leaf i / fanin, and the last arrival at a node
+// counts down its parent, so for large K no counter sees more than fanin
+// arrivals per phase. Nodes sit on their own cache lines. Arrival indices
+// must be distinct and below parties within a phase (the seat numbers).
+//
+// Waiting spins briefly, then sleeps on a futex (shared between processes
+// when pshared is set), polling for cancellation like the futex backend.
+#define PHASE_LINE 64
+#define PHASE_MAX_NODES 1024    // Enough for 1024 parties at fanin 2
+
+typedef struct {
+    int count;               // Arrivals this node still expects in the phase
+    int expected;            // Arrivals that complete it
+    int parent;              // -1 at the root
+    char pad[PHASE_LINE - 3 * sizeof(int)];
+} phase_node_t;
+
+typedef struct {
+    unsigned int generation; // Phases completed or released
+    int sleepers;            // Waiters asleep on the generation
+    int parties;
+    int fanin;               // 0 for a single counter
+    int leaves;              // Nodes 0 .. leaves - 1 take the arrivals
+    int root;
+    int pshared;
+    char pad[PHASE_LINE - 7 * sizeof(int)];
+    phase_node_t node[PHASE_MAX_NODES];
+} phase_barrier_t;
+
+// Returns -1 when parties and fanin need more than PHASE_MAX_NODES nodes.
+int phase_init(phase_barrier_t *b, int parties, int fanin, int pshared);
+unsigned int phase_generation(phase_barrier_t *b);
+// Counts arrival `index`; true for the arrival that completed the phase.
+bool phase_arrive(phase_barrier_t *b, int index);
+// Advances the generation directly, waking every waiter.
+void phase_release(phase_barrier_t *b);
+// Returns once the generation differs from seen.
+void phase_wait(phase_barrier_t *b, unsigned int seen);
+
+#endif
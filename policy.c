@@ -0,0 +1,155 @@
+#define _GNU_SOURCE     // rand_r under -std=c99
+
+#include <stdio.h>      // snprintf
+#include <stdlib.h>     // malloc, free, rand_r, strtoul
+#include <string.h>     // strcmp, memset, memcpy
+#include <dlfcn.h>      // dlopen, dlsym, dlclose
+#include "policy.h"
+
+// --- BUILT-IN POLICIES ---
+static int fifo_select(void *state, const ferry_dock_view_t *view,
+                       const ferry_waiting_car_t *waiting, int count) {
+    (void)state; (void)view; (void)waiting; (void)count;
+    return 0;    // The queue is oldest first
+}
+
+// The state is the rand_r seed; --policy-args sets it.
+static void *random_create(const char *args) {
+    unsigned int *seed = malloc(sizeof(unsigned int));
+    if (seed != NULL) *seed = args[0] != '\0' ? (unsigned int)strtoul(args, NULL, 10) : 1;
+    return seed;
+}
+
+static void random_destroy(void *state) {
+    free(state);
+}
+
+static int random_select(void *state, const ferry_dock_view_t *view,
+                         const ferry_waiting_car_t *waiting, int count) {
+    (void)view; (void)waiting;
+    return (int)(rand_r(state) % (unsigned int)count);
+}
+
+// Waiting for cars that are not there only delays the ones aboard.
+static int eager_depart(void *state, const ferry_dock_view_t *view) {
+    (void)state;
+    return view->queued == 0;
+}
+
+static const ferry_policy_t builtins[] = {
+    [POLICY_SEMAPHORE] = { FERRY_POLICY_ABI_VERSION, "semaphore", NULL, NULL, NULL, NULL, NULL },
+    [POLICY_FIFO] = { FERRY_POLICY_ABI_VERSION, "fifo", NULL, NULL, NULL, NULL, fifo_select },
+    [POLICY_RANDOM] = { FERRY_POLICY_ABI_VERSION, "random", random_create, random_destroy, NULL,
+                        NULL, random_select },
+    [POLICY_EAGER] = { FERRY_POLICY_ABI_VERSION, "eager", NULL, NULL, NULL, eager_depart,
+                       fifo_select },
+};
+
+// --- LOADING ---
+// Bytes of ferry_policy_t each ABI version defines. Versions only append
+// fields, so an older plugin's table is a prefix of the current one; when
+// a field is added, the older entries become offsetof() that field.
+static const size_t abi_table_size[FERRY_POLICY_ABI_VERSION + 1] = {
+    [1] = sizeof(ferry_policy_t),
+};
+
+int policy_load(policy_t *p, const char *spec, const char *args, char *error, size_t error_len) {
+    memset(p, 0, sizeof(*p));
+    if (args == NULL) args = "";
+    for (int k = 0; k < POLICY_PLUGIN; k++) {
+        if (strcmp(spec, builtins[k].name) == 0) {
+            p->kind = (policy_kind_t)k;
+            p->ops = &builtins[k];
+        }
+    }
+    if (p->ops == NULL) {
+        // Not a built-in: a shared object. RTLD_NOW reports a plugin with
+        // unresolved symbols here instead of in the middle of a run.
+        p->handle = dlopen(spec, RTLD_NOW | RTLD_LOCAL);
+        if (p->handle == NULL) {
+            snprintf(error, error_len, "%s is no built-in policy and cannot be loaded: %s", spec, dlerror());
+            return -1;
+        }
+        ferry_policy_entry_t entry;
+        // The POSIX-sanctioned way to turn dlsym's void * into a function pointer.
+        *(void **)&entry = dlsym(p->handle, FERRY_POLICY_ENTRY);
+        const ferry_policy_t *table = entry != NULL ? entry() : NULL;
+        if (table == NULL || table->abi_version < 1 || table->abi_version > FERRY_POLICY_ABI_VERSION) {
+            snprintf(error, error_len, "%s does not export a version %d %s() policy", spec,
+                     FERRY_POLICY_ABI_VERSION, FERRY_POLICY_ENTRY);
+            dlclose(p->handle);
+            p->handle = NULL;
+            return -1;
+        }
+        // Only the fields the plugin's version defines are read; newer
+        // ones stay NULL, so an older plugin keeps working.
+        memcpy(&p->plugin_ops, table, abi_table_size[table->abi_version]);
+        p->ops = &p->plugin_ops;
+        p->kind = POLICY_PLUGIN;
+    }
+    if (p->ops->create != NULL && (p->state = p->ops->create(args)) == NULL) {
+        snprintf(error, error_len, "policy %s rejected its arguments \"%s\"", p->ops->name, args);
+        policy_unload(p);
+        return -1;
+    }
+    return 0;
+}
+
+void policy_unload(policy_t *p) {
+    if (p->ops != NULL && p->ops->destroy != NULL && p->state != NULL) p->ops->destroy(p->state);
+    if (p->handle != NULL) dlclose(p->handle);
+    p->state = NULL;
+    p->handle = NULL;
+    p->ops = NULL;
+}
+
+const char *policy_name(const policy_t *p) {
+    return p->ops != NULL ? p->ops->name : "semaphore";
+}
+
+bool policy_orders_boarding(const policy_t *p) {
+    return p->ops != NULL && p->ops->select_next != NULL;
+}
+
+bool policy_decides_departure(const policy_t *p) {
+    return p->ops != NULL && p->ops->decide_depart != NULL;
+}
+
+// --- DISPATCH ---
+// Built-ins are called directly by kind; the callback table is only used
+// for plugins.
+void policy_notify(policy_t *p, const ferry_dock_view_t *view, ferry_policy_event_t event) {
+    if (p->kind == POLICY_PLUGIN && p->ops->on_state_change != NULL) {
+        p->ops->on_state_change(p->state, view, event);
+    }
+}
+
+int policy_select(policy_t *p, const ferry_dock_view_t *view,
+                  const ferry_waiting_car_t *waiting, int count) {
+    int pick;
+    switch (p->kind) {
+    case POLICY_FIFO:
+    case POLICY_EAGER:  pick = fifo_select(p->state, view, waiting, count); break;
+    case POLICY_RANDOM: pick = random_select(p->state, view, waiting, count); break;
+    default:            pick = p->ops->select_next(p->state, view, waiting, count); break;
+    }
+    p->selections++;
+    if (pick < 0 || pick >= count) {
+        p->bad_selections++;
+        pick = 0;
+    }
+    return pick;
+}
+
+bool policy_depart(policy_t *p, const ferry_dock_view_t *view) {
+    bool depart;
+    switch (p->kind) {
+    case POLICY_EAGER: depart = eager_depart(p->state, view); break;
+    case POLICY_PLUGIN:
+        depart = p->ops->decide_depart != NULL && p->ops->decide_depart(p->state, view);
+        break;
+    default: depart = false; break;
+    }
+    if (depart) p->departures++;
+    return depart;
+}
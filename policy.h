@@ -0,0 +1,53 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdbool.h>        // Boolean Type
+#include <stddef.h>         // size_t
+#include "ferry_policy.h"   // The plugin interface
+
+// --- POLICIES ---
+// Runs the departure and boarding policy of a run: a built-in, or a
+// plugin loaded with dlopen. Built-ins are compiled in and dispatched
+// through a switch, so the hot path makes direct (inlinable) calls; only
+// plugins go through the callback table. The built-ins also have tables,
+// which the policy benchmark calls to price the indirection.
+//   semaphore  the default: boarding in semaphore wake-up order, depart
+//              when full (no callbacks at all)
+//   fifo       the longest-waiting car boards first
+//   random     a uniformly random waiting car boards next
+//   eager      fifo, and departs as soon as nobody is left waiting
+typedef enum {
+    POLICY_SEMAPHORE,
+    POLICY_FIFO,
+    POLICY_RANDOM,
+    POLICY_EAGER,
+    POLICY_PLUGIN
+} policy_kind_t;
+
+typedef struct {
+    policy_kind_t kind;
+    const ferry_policy_t *ops;   // The built-in's table or plugin_ops
+    ferry_policy_t plugin_ops;   // A plugin's table, padded with NULLs to this ABI
+    void *state;                 // From ops->create
+    void *handle;                // dlopen handle of a plugin
+    unsigned long selections;    // select_next decisions
+    unsigned long bad_selections; // Out-of-range answers (replaced by 0)
+    unsigned long departures;    // decide_depart answers that sent the ferry
+} policy_t;
+
+// Loads a built-in by name, or else a shared object by path. Returns -1
+// with a message in error when neither works.
+int policy_load(policy_t *p, const char *spec, const char *args, char *error, size_t error_len);
+void policy_unload(policy_t *p);
+const char *policy_name(const policy_t *p);
+
+bool policy_orders_boarding(const policy_t *p);
+bool policy_decides_departure(const policy_t *p);
+
+void policy_notify(policy_t *p, const ferry_dock_view_t *view, ferry_policy_event_t event);
+// Index of the car to board next, always within 0 .. count - 1.
+int policy_select(policy_t *p, const ferry_dock_view_t *view,
+                  const ferry_waiting_car_t *waiting, int count);
+bool policy_depart(policy_t *p, const ferry_dock_view_t *view);
+
+#endif
@@ -0,0 +1,74 @@
+// An example --policy plugin, built as ferry_policy_example.so:
+//
+//     ./ferry_cross --policy ./ferry_policy_example.so --policy-args "3 500"
+//
+// Cars 1 .. N have priority and board before any other waiting car; among
+// themselves, and among the others, the longest-waiting goes first. The
+// ferry leaves at least half full once its first car has waited M ms.
+// The arguments are "N M" (default "1 1000"). It only includes the plugin
+// header, as any out-of-tree policy would.
+#include <stdio.h>      // sscanf, fprintf
+#include <stdlib.h>     // malloc, free
+#include "ferry_policy.h"
+
+typedef struct {
+    int priority_cars;               // Ids 1 .. priority_cars have priority
+    double wait_sec;                 // Depart half full after this long
+    unsigned long priority_boardings;
+    unsigned long boardings;
+} priority_state_t;
+
+static void *priority_create(const char *args) {
+    priority_state_t *s = calloc(1, sizeof(priority_state_t));
+    if (s == NULL) return NULL;
+    int wait_ms = 1000;
+    s->priority_cars = 1;
+    if (args[0] != '\0' &&
+        (sscanf(args, "%d %d", &s->priority_cars, &wait_ms) < 1 || s->priority_cars < 0 || wait_ms < 0)) {
+        free(s);
+        return NULL;
+    }
+    s->wait_sec = wait_ms / 1000.0;
+    return s;
+}
+
+static void priority_destroy(void *state) {
+    priority_state_t *s = state;
+    fprintf(stderr, "priority policy: %lu of %lu boardings had priority\n",
+            s->priority_boardings, s->boardings);
+    free(s);
+}
+
+static void priority_on_state_change(void *state, const ferry_dock_view_t *view,
+                                     ferry_policy_event_t event) {
+    priority_state_t *s = state;
+    if (event != FERRY_POLICY_BOARDED) return;
+    s->boardings++;
+    if (view->car_id <= s->priority_cars) s->priority_boardings++;
+}
+
+static int priority_decide_depart(void *state, const ferry_dock_view_t *view) {
+    const priority_state_t *s = state;
+    return 2 * view->aboard >= view->capacity && view->first_board_at >= 0 &&
+           view->now - view->first_board_at >= s->wait_sec;
+}
+
+// The queue is oldest first, so the first priority car is the one to take.
+static int priority_select_next(void *state, const ferry_dock_view_t *view,
+                                const ferry_waiting_car_t *waiting, int count) {
+    const priority_state_t *s = state;
+    (void)view;
+    for (int i = 0; i < count; i++) {
+        if (waiting[i].car_id <= s->priority_cars) return i;
+    }
+    return 0;
+}
+
+static const ferry_policy_t priority_policy = {
+    FERRY_POLICY_ABI_VERSION, "priority", priority_create, priority_destroy,
+    priority_on_state_change, priority_decide_depart, priority_select_next
+};
+
+const ferry_policy_t *ferry_policy(void) {
+    return &priority_policy;
+}
@@ -0,0 +1,269 @@
+#define _GNU_SOURCE     // mmap flags (MAP_ANONYMOUS, MAP_HUGETLB, MADV_HUGEPAGE) under -std=c99
+
+#include <stdlib.h>     // malloc, free
+#include <stdint.h>     // uintptr_t
+#include <sys/mman.h>   // mmap, madvise
+#include "pool.h"
+
+// All blocks are aligned to 16 bytes, enough for any record we store.
+#define POOL_ALIGN 16
+#define ALIGN_UP(n) (((n) + (POOL_ALIGN - 1)) & ~(size_t)(POOL_ALIGN - 1))
+
+// Huge page geometry. Blocks smaller than half a huge page stay on the heap.
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+#define PREFAULT_STRIDE 4096
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+// Number of heap calls made through counted_malloc/counted_free, and of
+// huge page mmap/munmap calls, which are not heap calls and are counted
+// apart. Updated atomically because pools are used from every thread.
+static unsigned long heap_calls = 0;
+static unsigned long map_calls = 0;
+
+// --- ALLOCATOR ACCOUNTING ---
+void *counted_malloc(size_t size) {
+    __atomic_fetch_add(&heap_calls, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void counted_free(void *ptr) {
+    if (ptr == NULL) return;
+    __atomic_fetch_add(&heap_calls, 1, __ATOMIC_RELAXED);
+    free(ptr);
+}
+
+unsigned long allocator_calls(void) {
+    return __atomic_load_n(&heap_calls, __ATOMIC_RELAXED);
+}
+
+unsigned long mapping_calls(void) {
+    return __atomic_load_n(&map_calls, __ATOMIC_RELAXED);
+}
+
+// --- LARGE MAPPINGS ---
+static page_mode_t page_mode = PAGES_NORMAL;   // Requested backing
+static page_mode_t page_backing = PAGES_NORMAL; // Weakest backing actually used
+static int large_blocks = 0;                    // Blocks mapped so far
+
+void pool_set_page_mode(page_mode_t mode) {
+    page_mode = mode;
+}
+
+page_mode_t pool_page_backing(void) {
+    return large_blocks > 0 ? page_backing : PAGES_NORMAL;
+}
+
+const char *page_mode_name(page_mode_t mode) {
+    switch (mode) {
+    case PAGES_TRANSPARENT: return "transparent";
+    case PAGES_EXPLICIT:    return "explicit";
+    default:                return "normal";
+    }
+}
+
+// Touches every page so the faults happen at startup, not on the hot path.
+static void prefault(void *ptr, size_t size) {
+    volatile unsigned char *bytes = ptr;
+    for (size_t off = 0; off < size; off += PREFAULT_STRIDE) {
+        bytes[off] = 0;
+    }
+}
+
+static void note_backing(page_mode_t used) {
+    if (large_blocks == 0 || used < page_backing) page_backing = used;
+    large_blocks++;
+}
+
+// Maps a huge-page aligned region and asks the kernel to back it with THP.
+static void *map_transparent(size_t size) {
+#ifdef MADV_HUGEPAGE
+    // Over-map by one huge page and trim, so the region starts on a huge
+    // page boundary and every page of it is eligible for promotion.
+    size_t span = size + HUGE_PAGE_SIZE;
+    unsigned char *raw = mmap(NULL, span, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    uintptr_t start = ((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    size_t head = start - (uintptr_t)raw;
+    if (head > 0) munmap(raw, head);
+    if (span - head > size) munmap((unsigned char*)start + size, span - head - size);
+
+    if (madvise((void*)start, size, MADV_HUGEPAGE) != 0) {
+        munmap((void*)start, size);
+        return NULL;
+    }
+    return (void*)start;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+
+static void *map_explicit(size_t size) {
+#ifdef MAP_HUGETLB
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+#else
+    (void)size;
+    return NULL;
+#endif
+}
+
+void *large_alloc(size_t size, size_t *mapped) {
+    *mapped = 0;
+
+    if (page_mode != PAGES_NORMAL && size >= HUGE_PAGE_SIZE / 2) {
+        size_t len = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        void *ptr = NULL;
+        page_mode_t used = PAGES_NORMAL;
+
+        __atomic_fetch_add(&map_calls, 1, __ATOMIC_RELAXED);
+        if (page_mode == PAGES_EXPLICIT && (ptr = map_explicit(len)) != NULL) {
+            used = PAGES_EXPLICIT;
+        } else if ((ptr = map_transparent(len)) != NULL) {
+            used = PAGES_TRANSPARENT;
+        }
+
+        if (ptr != NULL) {
+            note_backing(used);
+            prefault(ptr, len);
+            *mapped = len;
+            return ptr;
+        }
+        note_backing(PAGES_NORMAL);
+    }
+
+    void *ptr = counted_malloc(size);
+    if (ptr != NULL) prefault(ptr, size);
+    return ptr;
+}
+
+void large_free(void *ptr, size_t mapped) {
+    if (ptr == NULL) return;
+    if (mapped == 0) {
+        counted_free(ptr);
+        return;
+    }
+    __atomic_fetch_add(&map_calls, 1, __ATOMIC_RELAXED);
+    munmap(ptr, mapped);
+}
+
+// --- FIXED-SIZE POOL ---
+int pool_init(pool_t *pool, size_t obj_size, size_t capacity) {
+    if (obj_size < sizeof(pool_block_t)) obj_size = sizeof(pool_block_t);
+    pool->obj_size = ALIGN_UP(obj_size);
+    pool->capacity = capacity;
+    pool->free_list = NULL;
+
+    pool->storage = large_alloc(pool->obj_size * capacity, &pool->mapped);
+    if (pool->storage == NULL) return -1;
+
+    // Thread every object onto the free list, first object at the head.
+    for (size_t i = capacity; i > 0; i--) {
+        pool_block_t *block = (pool_block_t*)(pool->storage + (i - 1) * pool->obj_size);
+        block->next = pool->free_list;
+        pool->free_list = block;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    return 0;
+}
+
+// Returns a free object, or falls back to the heap when the pool is empty.
+void *pool_get(pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool_block_t *block = pool->free_list;
+    if (block != NULL) pool->free_list = block->next;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (block == NULL) return counted_malloc(pool->obj_size);
+    return block;
+}
+
+void pool_put(pool_t *pool, void *obj) {
+    if (obj == NULL) return;
+
+    // Objects that did not come from the backing block were heap fallbacks.
+    uintptr_t addr = (uintptr_t)obj;
+    uintptr_t lo = (uintptr_t)pool->storage;
+    uintptr_t hi = lo + pool->obj_size * pool->capacity;
+    if (addr < lo || addr >= hi) {
+        counted_free(obj);
+        return;
+    }
+
+    pool_block_t *block = obj;
+    pthread_mutex_lock(&pool->lock);
+    block->next = pool->free_list;
+    pool->free_list = block;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_destroy(pool_t *pool) {
+    pthread_mutex_destroy(&pool->lock);
+    large_free(pool->storage, pool->mapped);
+    pool->storage = NULL;
+    pool->free_list = NULL;
+}
+
+// --- BUMP ARENA ---
+int arena_init(arena_t *arena, size_t size) {
+    arena->size = ALIGN_UP(size);
+    arena->used = 0;
+    arena->overflow = NULL;
+    arena->fixed = 0;
+    arena->base = large_alloc(arena->size, &arena->mapped);
+    return arena->base == NULL ? -1 : 0;
+}
+
+void arena_init_at(arena_t *arena, void *base, size_t size) {
+    arena->base = base;
+    arena->size = size;
+    arena->mapped = 0;
+    arena->used = 0;
+    arena->overflow = NULL;
+    arena->fixed = 1;
+}
+
+// Each allocation is rounded up to the arena alignment, so callers sizing
+// an arena for a known number of records should use this helper.
+size_t arena_footprint(size_t obj_size, size_t count) {
+    return ALIGN_UP(obj_size) * count;
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    size = ALIGN_UP(size);
+    if (arena->used + size <= arena->size) {
+        void *ptr = arena->base + arena->used;
+        arena->used += size;
+        return ptr;
+    }
+    if (arena->fixed) return NULL;
+
+    // Arena exhausted: chain a heap block so the caller still gets memory.
+    arena_overflow_t *block = counted_malloc(ALIGN_UP(sizeof(arena_overflow_t)) + size);
+    if (block == NULL) return NULL;
+    block->next = arena->overflow;
+    arena->overflow = block;
+    return (unsigned char*)block + ALIGN_UP(sizeof(arena_overflow_t));
+}
+
+void arena_reset(arena_t *arena) {
+    while (arena->overflow != NULL) {
+        arena_overflow_t *next = arena->overflow->next;
+        counted_free(arena->overflow);
+        arena->overflow = next;
+    }
+    arena->used = 0;
+}
+
+void arena_destroy(arena_t *arena) {
+    arena_reset(arena);
+    if (!arena->fixed) large_free(arena->base, arena->mapped);
+    arena->base = NULL;
+}
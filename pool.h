@@ -0,0 +1,84 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>     // size_t
+#include <pthread.h>    // Mutex protecting the pool free list
+
+// --- LARGE MAPPINGS ---
+// How big backing blocks are mapped. Huge pages cut TLB misses when the
+// pools hold many agents; each mode falls back to the next weaker one
+// (explicit -> transparent -> normal) when the system refuses it.
+typedef enum {
+    PAGES_NORMAL,       // Regular heap memory
+    PAGES_TRANSPARENT,  // mmap + madvise(MADV_HUGEPAGE)
+    PAGES_EXPLICIT      // mmap(MAP_HUGETLB) from the hugetlbfs reserve
+} page_mode_t;
+
+void pool_set_page_mode(page_mode_t mode);
+page_mode_t pool_page_backing(void);
+const char *page_mode_name(page_mode_t mode);
+
+// Allocates and pre-faults a backing block. *mapped receives the mapping
+// length to pass back to large_free (0 when the block came from the heap).
+void *large_alloc(size_t size, size_t *mapped);
+void large_free(void *ptr, size_t mapped);
+
+// --- FIXED-SIZE POOL ---
+// Hands out equally sized objects from one block reserved at startup.
+// Returned objects go back on a free list and are reused, so the hot path
+// never reaches malloc/free while the pool has room.
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+typedef struct {
+    unsigned char *storage;   // Backing block (obj_size * capacity bytes)
+    size_t obj_size;          // Rounded up to keep every object aligned
+    size_t capacity;          // Number of objects in the backing block
+    size_t mapped;            // Mapping length of the backing block
+    pool_block_t *free_list;  // Objects currently available
+    pthread_mutex_t lock;     // Pools are shared between threads
+} pool_t;
+
+int pool_init(pool_t *pool, size_t obj_size, size_t capacity);
+void *pool_get(pool_t *pool);
+void pool_put(pool_t *pool, void *obj);
+void pool_destroy(pool_t *pool);
+
+// --- BUMP ARENA ---
+// Linear allocator for short-lived records. Everything allocated from it is
+// released at once by arena_reset(), which the simulator calls once per
+// ferry cycle. Running out of room falls back to the heap (and is counted).
+typedef struct arena_overflow {
+    struct arena_overflow *next;
+} arena_overflow_t;
+
+typedef struct {
+    unsigned char *base;         // Backing block reserved at startup
+    size_t size;                 // Size of the backing block
+    size_t mapped;               // Mapping length of the backing block
+    size_t used;                 // Bump offset into the backing block
+    arena_overflow_t *overflow;  // Heap blocks taken when the arena is full
+    int fixed;                   // Caller-provided block, no heap fallback
+} arena_t;
+
+int arena_init(arena_t *arena, size_t size);
+// Arena over a block the caller owns, such as part of a shared mapping.
+// A heap block would be private to one process, so instead of falling back
+// to the heap arena_alloc returns NULL when the block is full.
+void arena_init_at(arena_t *arena, void *base, size_t size);
+size_t arena_footprint(size_t obj_size, size_t count); // Bytes for count records
+void *arena_alloc(arena_t *arena, size_t size);
+void arena_reset(arena_t *arena);
+void arena_destroy(arena_t *arena);
+
+// --- ALLOCATOR ACCOUNTING ---
+// Every heap call made by the pools and arenas goes through these wrappers,
+// so the simulator can report how often the hot path touched the allocator.
+void *counted_malloc(size_t size);
+void counted_free(void *ptr);
+unsigned long allocator_calls(void);
+// Huge page mappings made and released by large_alloc/large_free.
+unsigned long mapping_calls(void);
+
+#endif
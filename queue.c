@@ -0,0 +1,131 @@
+#define _GNU_SOURCE     // posix_memalign under -std=c99
+
+#include <stdlib.h>     // posix_memalign, free
+#include <string.h>     // memset, strcmp
+#include <stdint.h>     // intptr_t
+#include "queue.h"
+
+static const char *kind_names[QUEUE_KINDS] = { "vyukov", "mutex" };
+
+const char *queue_kind_name(queue_kind_t kind) {
+    return kind < QUEUE_KINDS ? kind_names[kind] : "unknown";
+}
+
+int queue_kind_parse(const char *name) {
+    for (int k = 0; k < QUEUE_KINDS; k++) {
+        if (strcmp(name, kind_names[k]) == 0) return k;
+    }
+    return -1;
+}
+
+int queue_init(dock_queue_t *q, queue_kind_t kind, size_t capacity) {
+    memset(q, 0, sizeof(*q));
+    q->kind = kind;
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    q->mask = size - 1;
+
+    if (kind == QUEUE_VYUKOV) {
+        if (posix_memalign(&q->block, QUEUE_LINE, size * sizeof(queue_cell_t)) != 0) return -1;
+        q->cells = q->block;
+        // Cell i is ready for the producer that claims position i.
+        for (size_t i = 0; i < size; i++) {
+            q->cells[i].sequence = i;
+            q->cells[i].value = NULL;
+        }
+        return 0;
+    }
+    q->block = malloc(size * sizeof(void *));
+    if (q->block == NULL) return -1;
+    q->items = q->block;
+    return pthread_mutex_init(&q->lock, NULL) == 0 ? 0 : -1;
+}
+
+// --- VYUKOV MPMC ---
+// A cell whose sequence equals the position is free for that position's
+// producer; one past it holds a value for that position's consumer. After
+// the consumer drains it the sequence jumps a lap ahead, freeing it for
+// the producer one lap later. The acquire load of the sequence pairs with
+// the release store that published it, so the value is visible.
+static bool vyukov_push(dock_queue_t *q, void *value) {
+    size_t pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        queue_cell_t *cell = &q->cells[pos & q->mask];
+        size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->enqueue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                cell->value = value;
+                __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            // The failed CAS reloaded pos; try the new cell.
+        } else if (diff < 0) {
+            return false;    // The cell still holds last lap's value: full
+        } else {
+            pos = __atomic_load_n(&q->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static bool vyukov_pop(dock_queue_t *q, void **value) {
+    size_t pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        queue_cell_t *cell = &q->cells[pos & q->mask];
+        size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&q->dequeue_pos, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *value = cell->value;
+                __atomic_store_n(&cell->sequence, pos + q->mask + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;    // Not yet filled: empty
+        } else {
+            pos = __atomic_load_n(&q->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// --- MUTEX DEQUE ---
+static bool mutex_push(dock_queue_t *q, void *value) {
+    bool pushed = false;
+    pthread_mutex_lock(&q->lock);
+    if (q->enqueue_pos - q->dequeue_pos <= q->mask) {
+        q->items[q->enqueue_pos++ & q->mask] = value;
+        pushed = true;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return pushed;
+}
+
+static bool mutex_pop(dock_queue_t *q, void **value) {
+    bool popped = false;
+    pthread_mutex_lock(&q->lock);
+    if (q->dequeue_pos != q->enqueue_pos) {
+        *value = q->items[q->dequeue_pos++ & q->mask];
+        popped = true;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return popped;
+}
+
+// --- DISPATCH ---
+bool queue_push(dock_queue_t *q, void *value) {
+    return q->kind == QUEUE_VYUKOV ? vyukov_push(q, value) : mutex_push(q, value);
+}
+
+bool queue_pop(dock_queue_t *q, void **value) {
+    return q->kind == QUEUE_VYUKOV ? vyukov_pop(q, value) : mutex_pop(q, value);
+}
+
+void queue_destroy(dock_queue_t *q) {
+    if (q->kind == QUEUE_MUTEX) pthread_mutex_destroy(&q->lock);
+    free(q->block);
+    q->block = NULL;
+    q->cells = NULL;
+    q->items = NULL;
+}
@@ -0,0 +1,57 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stddef.h>     // size_t
+#include <stdbool.h>    // Boolean Type
+#include <pthread.h>    // Mutex of the locked deque
+
+// --- DOCK QUEUES ---
+// Bounded multi-producer multi-consumer FIFO of pointers: arriving cars
+// push, boarding ferries pop. Two implementations share one interface:
+//   vyukov  lock-free ring of sequence-numbered cells (Dmitry Vyukov's
+//           bounded MPMC queue). A producer claims a cell with one CAS on
+//           the enqueue position and publishes it by bumping the cell's
+//           sequence; consumers do the same on the dequeue position. Each
+//           cell and both positions sit on their own cache line, so
+//           producers and consumers only meet on the cells they hand over.
+//   mutex   ring-buffer deque under a pthread mutex, the baseline.
+// Push fails when the queue is full and pop when it is empty; neither
+// blocks, callers decide how to wait.
+typedef enum {
+    QUEUE_VYUKOV,
+    QUEUE_MUTEX
+} queue_kind_t;
+
+#define QUEUE_KINDS 2
+#define QUEUE_LINE 64
+
+typedef struct {
+    size_t sequence;         // Position this cell is ready for
+    void *value;
+    char pad[QUEUE_LINE - sizeof(size_t) - sizeof(void *)];
+} queue_cell_t;
+
+typedef struct {
+    queue_kind_t kind;
+    size_t mask;             // Capacity - 1 (capacity is a power of two)
+    queue_cell_t *cells;     // vyukov: one line per cell
+    void **items;            // mutex: plain ring
+    void *block;             // Allocation behind cells or items
+    char pad0[QUEUE_LINE];
+    size_t enqueue_pos;      // vyukov: next cell to fill; mutex: tail
+    char pad1[QUEUE_LINE - sizeof(size_t)];
+    size_t dequeue_pos;      // vyukov: next cell to drain; mutex: head
+    char pad2[QUEUE_LINE - sizeof(size_t)];
+    pthread_mutex_t lock;    // mutex kind only
+} dock_queue_t;
+
+const char *queue_kind_name(queue_kind_t kind);
+int queue_kind_parse(const char *name);  // -1 when unknown
+
+// Capacity is rounded up to a power of two. Returns -1 when out of memory.
+int queue_init(dock_queue_t *q, queue_kind_t kind, size_t capacity);
+bool queue_push(dock_queue_t *q, void *value);
+bool queue_pop(dock_queue_t *q, void **value);
+void queue_destroy(dock_queue_t *q);
+
+#endif
@@ -0,0 +1,325 @@
+#define _GNU_SOURCE     // flock, fileno, ftruncate under -std=c99
+
+#include <stdlib.h>     // malloc, free
+#include <string.h>     // memcpy, memcmp, strcmp
+#include <stdbool.h>    // Boolean Type
+#include <sys/file.h>   // flock
+#include <unistd.h>     // ftruncate
+#include "results.h"
+
+// --- BYTE ENCODING ---
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static void put_f64(uint8_t *p, double d) {
+    uint64_t v;
+    memcpy(&v, &d, sizeof(v));
+    put_u64(p, v);
+}
+
+static double get_f64(const uint8_t *p) {
+    uint64_t v = get_u64(p);
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+static int write_f64(FILE *f, double d) {
+    uint8_t b[8];
+    put_f64(b, d);
+    return fwrite(b, 1, 8, f) == 8 ? 0 : -1;
+}
+
+// --- SCHEMA ---
+static int write_schema(const results_file_t *rf, FILE *f) {
+    uint8_t b[4];
+    if (fwrite(RESULTS_MAGIC, 1, 8, f) != 8) return -1;
+    put_u32(b, (uint32_t)rf->columns);
+    if (fwrite(b, 1, 4, f) != 4) return -1;
+    for (int c = 0; c < rf->columns; c++) {
+        size_t len = strlen(rf->names[c]);
+        fputc((int)len, f);
+        if (fwrite(rf->names[c], 1, len, f) != len) return -1;
+    }
+    return 0;
+}
+
+// Reads the magic and schema at the start of an open file. Returns 1 when
+// the file ends inside them (a first append cut off before any data).
+static int load_schema(results_file_t *rf) {
+    uint8_t b[8];
+    if (fseek(rf->file, 0, SEEK_SET) != 0) return -1;
+    size_t n = fread(b, 1, 8, rf->file);
+    if (memcmp(b, RESULTS_MAGIC, n) != 0) return -1;
+    if (n < 8 || fread(b, 1, 4, rf->file) != 4) return 1;
+    rf->columns = (int)get_u32(b);
+    if (rf->columns <= 0 || rf->columns > RESULTS_MAX_COLUMNS) return -1;
+    for (int c = 0; c < rf->columns; c++) {
+        int len = fgetc(rf->file);
+        if (len == EOF) return 1;
+        if (len == 0 || len >= RESULTS_NAME_LEN) return -1;
+        if (fread(rf->names[c], 1, len, rf->file) != (size_t)len) return 1;
+        rf->names[c][len] = '\0';
+    }
+    rf->data_start = (uint64_t)ftell(rf->file);
+    return 0;
+}
+
+// --- FOOTERS ---
+#define RESULTS_SCAN_CHUNK 65536   // Bytes per read of the trailer search
+
+static size_t footer_size(int columns) {
+    return 20 + 16 * (size_t)columns;
+}
+
+static uint64_t stripe_size(int columns, uint32_t rows) {
+    return (uint64_t)rows * ((uint64_t)columns * 8 + RESULTS_TAG_LEN);
+}
+
+// Reads the footer at offset. Appends are contiguous, so a valid footer
+// directly follows its stripe, which directly follows the previous
+// append's trailer (or the schema).
+static int read_footer(const results_file_t *rf, uint64_t offset, results_stripe_t *st,
+                       uint64_t *prev) {
+    uint8_t b[20 + 16 * RESULTS_MAX_COLUMNS];
+    size_t n = footer_size(rf->columns);
+    if (offset < rf->data_start || fseek(rf->file, (long)offset, SEEK_SET) != 0 ||
+        fread(b, 1, n, rf->file) != n) return -1;
+    *prev = get_u64(b);
+    st->offset = get_u64(b + 8);
+    st->rows = get_u32(b + 16);
+    for (int c = 0; c < rf->columns; c++) {
+        st->min[c] = get_f64(b + 20 + 16 * c);
+        st->max[c] = get_f64(b + 28 + 16 * c);
+    }
+    if (st->rows == 0 || st->offset + stripe_size(rf->columns, st->rows) != offset) return -1;
+    if (*prev == 0) return st->offset == rf->data_start ? 0 : -1;
+    return *prev + n + 16 == st->offset ? 0 : -1;
+}
+
+// Whether a complete append ends at end; sets *footer to its footer.
+static bool append_ends_at(const results_file_t *rf, uint64_t end, uint64_t *footer) {
+    uint8_t t[16];
+    results_stripe_t st;
+    uint64_t prev;
+    if (end < rf->data_start + 16 || fseek(rf->file, (long)(end - 16), SEEK_SET) != 0 ||
+        fread(t, 1, 16, rf->file) != 16 || memcmp(t + 8, RESULTS_TRAILER_MAGIC, 8) != 0) {
+        return false;
+    }
+    *footer = get_u64(t);
+    return *footer + footer_size(rf->columns) + 16 == end &&
+           read_footer(rf, *footer, &st, &prev) == 0;
+}
+
+// Finds the end of the last complete append, and its footer (0 when
+// none): the end of the file, unless an append was cut off. Then the file
+// is scanned back for the last trailer that closes a valid append.
+// Returns -1 when the file cannot be read, so nothing is truncated.
+static int committed_end(const results_file_t *rf, uint64_t size, uint64_t *end, uint64_t *footer) {
+    *footer = 0;
+    *end = rf->data_start;
+    if (size <= rf->data_start) return 0;
+    if (append_ends_at(rf, size, footer)) {
+        *end = size;
+        return 0;
+    }
+    uint8_t *chunk = malloc(RESULTS_SCAN_CHUNK);
+    if (chunk == NULL) return -1;
+    int rc = 0;
+    uint64_t hi = size;   // Candidate trailers end at or before hi
+    while (hi >= rf->data_start + 16) {
+        uint64_t lo = hi - rf->data_start > RESULTS_SCAN_CHUNK ? hi - RESULTS_SCAN_CHUNK : rf->data_start;
+        size_t n = (size_t)(hi - lo);
+        if (fseek(rf->file, (long)lo, SEEK_SET) != 0 || fread(chunk, 1, n, rf->file) != n) {
+            rc = -1;
+            break;
+        }
+        for (size_t i = n; i >= 16 && *end == rf->data_start; i--) {
+            if (memcmp(chunk + i - 8, RESULTS_TRAILER_MAGIC, 8) == 0 &&
+                append_ends_at(rf, lo + i, footer)) {
+                *end = lo + i;
+            }
+        }
+        if (*end != rf->data_start || lo == rf->data_start) break;
+        hi = lo + 15;     // Overlap, so a trailer across the boundary is seen
+    }
+    free(chunk);
+    if (*end == rf->data_start) *footer = 0;
+    return rc;
+}
+
+// Collects the stripe directory by following the footers back from the
+// last one, then puts it in file order.
+static int load_stripes(results_file_t *rf, uint64_t footer) {
+    uint32_t capacity = 0;
+    rf->stripe_count = 0;
+    rf->rows = 0;
+    while (footer != 0) {
+        if (rf->stripe_count == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            results_stripe_t *grown = realloc(rf->stripes, sizeof(results_stripe_t) * capacity);
+            if (grown == NULL) return -1;
+            rf->stripes = grown;
+        }
+        results_stripe_t *st = &rf->stripes[rf->stripe_count];
+        if (read_footer(rf, footer, st, &footer) != 0) return -1;
+        rf->rows += st->rows;
+        rf->stripe_count++;
+    }
+    for (uint32_t i = 0; i < rf->stripe_count / 2; i++) {
+        results_stripe_t t = rf->stripes[i];
+        rf->stripes[i] = rf->stripes[rf->stripe_count - 1 - i];
+        rf->stripes[rf->stripe_count - 1 - i] = t;
+    }
+    return 0;
+}
+
+// --- WRITER ---
+int results_append(const char *path, int columns, const char names[][RESULTS_NAME_LEN],
+                   uint32_t rows, const double *values, const char tags[][RESULTS_TAG_LEN]) {
+    if (columns <= 0 || columns > RESULTS_MAX_COLUMNS || rows == 0) return -1;
+
+    FILE *f = fopen(path, "a+b");
+    if (f == NULL) return -1;
+    if (flock(fileno(f), LOCK_EX) != 0) { fclose(f); return -1; }
+
+    results_file_t rf;
+    memset(&rf, 0, sizeof(rf));
+    rf.file = f;
+    int rc = -1;
+    uint64_t prev_footer = 0;
+
+    fseek(f, 0, SEEK_END);
+    uint64_t size = (uint64_t)ftell(f);
+    int schema = size == 0 ? 1 : load_schema(&rf);
+    if (schema < 0) goto out;
+    if (schema == 1) {
+        // New file, or one whose first append stopped inside the schema.
+        if (size > 0 && ftruncate(fileno(f), 0) != 0) goto out;
+        // load_schema() read from the stream, which may not be written
+        // without a positioning call; this also drops its stale buffer.
+        rewind(f);
+        rf.columns = columns;
+        for (int c = 0; c < columns; c++) {
+            strncpy(rf.names[c], names[c], RESULTS_NAME_LEN - 1);
+        }
+        if (write_schema(&rf, f) != 0) goto out;
+    } else {
+        if (rf.columns != columns) goto out;
+        for (int c = 0; c < columns; c++) {
+            if (strncmp(rf.names[c], names[c], RESULTS_NAME_LEN - 1) != 0) goto out;
+        }
+        // Drop the remains of an append that was cut off.
+        uint64_t end;
+        if (committed_end(&rf, size, &end, &prev_footer) != 0) goto out;
+        if (end < size && ftruncate(fileno(f), (off_t)end) != 0) goto out;
+    }
+
+    // "a+" mode: every write lands at the end of the file.
+    results_stripe_t st;
+    memset(&st, 0, sizeof(st));
+    fseek(f, 0, SEEK_END);
+    st.offset = (uint64_t)ftell(f);
+    st.rows = rows;
+    for (int c = 0; c < columns; c++) {
+        st.min[c] = st.max[c] = values[c];
+        for (uint32_t r = 0; r < rows; r++) {
+            double v = values[r * columns + c];
+            if (v < st.min[c]) st.min[c] = v;
+            if (v > st.max[c]) st.max[c] = v;
+            if (write_f64(f, v) != 0) goto out;
+        }
+    }
+    for (uint32_t r = 0; r < rows; r++) {
+        char tag[RESULTS_TAG_LEN] = { 0 };
+        strncpy(tag, tags[r], RESULTS_TAG_LEN - 1);
+        if (fwrite(tag, 1, RESULTS_TAG_LEN, f) != RESULTS_TAG_LEN) goto out;
+    }
+
+    // The footer, then the trailer that commits the append.
+    uint8_t b[8];
+    uint64_t footer_offset = st.offset + stripe_size(columns, rows);
+    put_u64(b, prev_footer);
+    if (fwrite(b, 1, 8, f) != 8) goto out;
+    put_u64(b, st.offset);
+    if (fwrite(b, 1, 8, f) != 8) goto out;
+    put_u32(b, st.rows);
+    if (fwrite(b, 1, 4, f) != 4) goto out;
+    for (int c = 0; c < columns; c++) {
+        if (write_f64(f, st.min[c]) != 0 || write_f64(f, st.max[c]) != 0) goto out;
+    }
+    put_u64(b, footer_offset);
+    if (fwrite(b, 1, 8, f) != 8 || fwrite(RESULTS_TRAILER_MAGIC, 1, 8, f) != 8) goto out;
+    rc = 0;
+
+out:
+    if (fflush(f) != 0) rc = -1;
+    flock(fileno(f), LOCK_UN);
+    fclose(f);
+    return rc;
+}
+
+// --- READER ---
+int results_open(results_file_t *rf, const char *path) {
+    memset(rf, 0, sizeof(*rf));
+    rf->file = fopen(path, "rb");
+    if (rf->file == NULL) return -1;
+
+    uint64_t end, footer;
+    int rc = load_schema(rf) != 0 || fseek(rf->file, 0, SEEK_END) != 0 ? -1 : 0;
+    if (rc == 0) rc = committed_end(rf, (uint64_t)ftell(rf->file), &end, &footer);
+    if (rc == 0) rc = load_stripes(rf, footer);
+    if (rc != 0) results_close(rf);
+    return rc;
+}
+
+void results_close(results_file_t *rf) {
+    if (rf->file != NULL) fclose(rf->file);
+    free(rf->stripes);
+    memset(rf, 0, sizeof(*rf));
+}
+
+int results_column(const results_file_t *rf, const char *name) {
+    for (int c = 0; c < rf->columns; c++) {
+        if (strcmp(rf->names[c], name) == 0) return c;
+    }
+    return -1;
+}
+
+int results_read_column(const results_file_t *rf, uint32_t stripe, int column, double *out) {
+    const results_stripe_t *st = &rf->stripes[stripe];
+    long offset = (long)(st->offset + (uint64_t)column * st->rows * 8);
+    if (fseek(rf->file, offset, SEEK_SET) != 0) return -1;
+    for (uint32_t r = 0; r < st->rows; r++) {
+        uint8_t b[8];
+        if (fread(b, 1, 8, rf->file) != 8) return -1;
+        out[r] = get_f64(b);
+    }
+    return 0;
+}
+
+int results_read_tags(const results_file_t *rf, uint32_t stripe, char out[][RESULTS_TAG_LEN]) {
+    const results_stripe_t *st = &rf->stripes[stripe];
+    long offset = (long)(st->offset + (uint64_t)rf->columns * st->rows * 8);
+    if (fseek(rf->file, offset, SEEK_SET) != 0) return -1;
+    if (fread(out, RESULTS_TAG_LEN, st->rows, rf->file) != st->rows) return -1;
+    for (uint32_t r = 0; r < st->rows; r++) out[r][RESULTS_TAG_LEN - 1] = '\0';
+    return 0;
+}
@@ -0,0 +1,66 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdint.h>     // Fixed-width fields of the file format
+#include <stdio.h>      // FILE
+
+// --- COLUMNAR RESULTS STORE ---
+// Append-only file of per-run metrics, stored column by column so a scan
+// over thousands of runs only reads the columns it needs.
+//
+//   "FERRYRS2"
+//   schema     u32 column count, per column u8 name length + name
+//   append*    stripe   every numeric column as rows f64s, then the tag
+//                       column as rows fixed-size strings
+//              footer   u64 offset of the previous footer (0 for the
+//                       first), u64 stripe offset, u32 rows and a
+//                       (min, max) f64 pair per numeric column
+//              trailer  u64 footer offset, "FERRYRSF"
+//
+// Each append writes only its own stripe, footer and trailer, so the file
+// grows linearly with the runs. Readers start at the last trailer and
+// follow the footers back. The trailer is written last: an append cut off
+// partway leaves bytes no trailer covers, which readers ignore and the
+// next append truncates. The per-stripe min/max let filters skip whole
+// stripes, and `ferry_results compact` rewrites many small stripes into
+// one. All integers and floats are little-endian.
+#define RESULTS_MAGIC "FERRYRS2"
+#define RESULTS_TRAILER_MAGIC "FERRYRSF"
+#define RESULTS_MAX_COLUMNS 32
+#define RESULTS_NAME_LEN 32     // Longest column name, including the NUL
+#define RESULTS_TAG_LEN 32      // Bytes of the run tag column, including the NUL
+
+typedef struct {
+    uint64_t offset;
+    uint32_t rows;
+    double min[RESULTS_MAX_COLUMNS];
+    double max[RESULTS_MAX_COLUMNS];
+} results_stripe_t;
+
+typedef struct {
+    FILE *file;
+    int columns;
+    char names[RESULTS_MAX_COLUMNS][RESULTS_NAME_LEN];
+    uint32_t stripe_count;
+    results_stripe_t *stripes;
+    uint64_t rows;              // Total over all stripes
+    uint64_t data_start;        // First byte after the schema
+} results_file_t;
+
+// Appends rows (values[row * columns + col], tags[row]) under an exclusive
+// file lock. Creates the file when missing; otherwise the column names
+// must match the stored schema. Returns 0 on success.
+int results_append(const char *path, int columns, const char names[][RESULTS_NAME_LEN],
+                   uint32_t rows, const double *values, const char tags[][RESULTS_TAG_LEN]);
+
+int results_open(results_file_t *rf, const char *path);
+void results_close(results_file_t *rf);
+
+// Index of a column by name, or -1.
+int results_column(const results_file_t *rf, const char *name);
+
+// Reads one column of one stripe into out (stripe rows entries).
+int results_read_column(const results_file_t *rf, uint32_t stripe, int column, double *out);
+int results_read_tags(const results_file_t *rf, uint32_t stripe, char out[][RESULTS_TAG_LEN]);
+
+#endif
@@ -0,0 +1,201 @@
+#include <stdio.h>      // fopen, fgets, snprintf
+#include <stdlib.h>     // strtod, strtol, malloc, realloc, qsort
+#include <string.h>     // strtok, strcmp, strstr, strchr, memcpy, memset
+#include "scenario.h"
+
+#define SCENARIO_LINE 256
+#define SCENARIO_MAX_TOKENS 8
+
+// --- PARSING ---
+// A factor is F or a ramp F1..F2; both ends must be positive. The ends
+// are split first, as strtod would read "1..4" as "1." and ".4".
+static int parse_number(const char *begin, const char *end, double *v) {
+    char buf[32];
+    if (end - begin <= 0 || end - begin >= (long)sizeof(buf)) return -1;
+    memcpy(buf, begin, end - begin);
+    buf[end - begin] = '\0';
+    char *stop;
+    *v = strtod(buf, &stop);
+    return stop != buf && *stop == '\0' && *v > 0 ? 0 : -1;
+}
+
+static int parse_factor(const char *tok, double *from, double *to) {
+    const char *dots = strstr(tok, "..");
+    const char *end = tok + strlen(tok);
+    if (dots == NULL) {
+        if (parse_number(tok, end, from) != 0) return -1;
+        *to = *from;
+        return 0;
+    }
+    return parse_number(tok, dots, from) == 0 && parse_number(dots + 2, end, to) == 0 ? 0 : -1;
+}
+
+static int parse_time(const char *tok, double *t) {
+    char *end;
+    *t = strtod(tok, &end);
+    return end != tok && *end == '\0' && *t >= 0 ? 0 : -1;
+}
+
+// "from T1 to T2" starting at tok[i].
+static int parse_window(char **tok, int n, int i, double *begin, double *end) {
+    if (n != i + 4 || strcmp(tok[i], "from") != 0 || strcmp(tok[i + 2], "to") != 0) return -1;
+    if (parse_time(tok[i + 1], begin) != 0 || parse_time(tok[i + 3], end) != 0) return -1;
+    return *end > *begin ? 0 : -1;
+}
+
+static int add_event(scenario_t *s, int *capacity, double at, scenario_event_kind_t kind,
+                     int value, int line) {
+    if (s->event_count == *capacity) {
+        int grown = *capacity ? 2 * *capacity : 16;
+        scenario_event_t *events = realloc(s->events, sizeof(scenario_event_t) * grown);
+        if (events == NULL) return -1;
+        s->events = events;
+        *capacity = grown;
+    }
+    scenario_event_t *e = &s->events[s->event_count++];
+    e->at = at;
+    e->kind = kind;
+    e->value = value;
+    e->line = line;
+    return 0;
+}
+
+// --- COMPILATION ---
+// Multiplies the steps a window touches by its factor, interpolating a
+// ramp at each step's midpoint. Every window covers at least one step.
+static void apply_window(const scenario_t *s, float *table, double begin, double end,
+                         double from, double to) {
+    // Times are non-negative, so truncation rounds down. Steps past the
+    // end of the run are never looked up.
+    if (begin / s->step_sec >= s->steps) return;
+    int first = (int)(begin / s->step_sec);
+    double stop = end / s->step_sec < s->steps ? end / s->step_sec : s->steps;
+    int last = (int)stop == stop ? (int)stop - 1 : (int)stop;
+    if (last < first) last = first;
+    for (int i = first; i <= last; i++) {
+        double mid = (i + 0.5) * s->step_sec;
+        double frac = (mid - begin) / (end - begin);
+        if (frac < 0) frac = 0;
+        if (frac > 1) frac = 1;
+        table[i] *= (float)(from + (to - from) * frac);
+    }
+}
+
+// Time order; at the same time ends come first, so back-to-back windows
+// hand over, then script order.
+static int compare_events(const void *a, const void *b) {
+    const scenario_event_t *x = a, *y = b;
+    if (x->at != y->at) return x->at < y->at ? -1 : 1;
+    if (x->kind != y->kind) return (int)x->kind - (int)y->kind;
+    return x->line - y->line;
+}
+
+int scenario_compile(scenario_t *s, const char *path, double runtime_sec, int max_capacity,
+                     char *error, size_t error_len) {
+    memset(s, 0, sizeof(*s));
+    // One step per 0.1 s, coarser for runs too long for SCENARIO_MAX_STEPS.
+    s->step_sec = SCENARIO_MIN_STEP;
+    s->steps = (int)(runtime_sec / s->step_sec) + 2;
+    if (s->steps > SCENARIO_MAX_STEPS) {
+        s->steps = SCENARIO_MAX_STEPS;
+        s->step_sec = runtime_sec / (SCENARIO_MAX_STEPS - 1);
+    }
+    s->rate = malloc(sizeof(float) * s->steps);
+    s->crossing = malloc(sizeof(float) * s->steps);
+    FILE *f = fopen(path, "r");
+    if (s->rate == NULL || s->crossing == NULL || f == NULL) {
+        snprintf(error, error_len, "cannot load %s", path);
+        if (f != NULL) fclose(f);
+        scenario_free(s);
+        return -1;
+    }
+    for (int i = 0; i < s->steps; i++) s->rate[i] = s->crossing[i] = 1.0f;
+
+    char line[SCENARIO_LINE];
+    int lineno = 0, status = 0, event_capacity = 0;
+    while (status == 0 && fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash != NULL) *hash = '\0';
+        char *tok[SCENARIO_MAX_TOKENS + 1];
+        int n = 0;
+        for (char *t = strtok(line, " \t\r\n"); t != NULL && n <= SCENARIO_MAX_TOKENS;
+             t = strtok(NULL, " \t\r\n")) {
+            tok[n++] = t;
+        }
+        if (n == 0) continue;
+
+        double begin, end, from, to, length;
+        char *rest;
+        if ((strcmp(tok[0], "rate") == 0 || strcmp(tok[0], "crossing") == 0) && n >= 2 &&
+            parse_factor(tok[1], &from, &to) == 0 && parse_window(tok, n, 2, &begin, &end) == 0) {
+            apply_window(s, tok[0][0] == 'r' ? s->rate : s->crossing, begin, end, from, to);
+        } else if (strcmp(tok[0], "surge") == 0 && n == 6 && parse_factor(tok[1], &from, &to) == 0 &&
+                   strcmp(tok[2], "at") == 0 && parse_time(tok[3], &begin) == 0 &&
+                   strcmp(tok[4], "for") == 0 && parse_time(tok[5], &length) == 0 && length > 0) {
+            apply_window(s, s->rate, begin, begin + length, from, to);
+        } else if (strcmp(tok[0], "maintenance") == 0 && parse_window(tok, n, 1, &begin, &end) == 0) {
+            if (add_event(s, &event_capacity, begin, SCENARIO_MAINTENANCE_BEGIN, 0, lineno) != 0 ||
+                add_event(s, &event_capacity, end, SCENARIO_MAINTENANCE_END, 0, lineno) != 0) {
+                status = -1;
+            }
+        } else if (strcmp(tok[0], "capacity") == 0 && n >= 2 && parse_window(tok, n, 2, &begin, &end) == 0) {
+            long seats = strtol(tok[1], &rest, 10);
+            if (*rest != '\0' || seats < 1 || seats > max_capacity) {
+                snprintf(error, error_len, "%s:%d: capacity must be 1..%d", path, lineno, max_capacity);
+                fclose(f);
+                scenario_free(s);
+                return -1;
+            }
+            if (add_event(s, &event_capacity, begin, SCENARIO_CAPACITY_BEGIN, (int)seats, lineno) != 0 ||
+                add_event(s, &event_capacity, end, SCENARIO_CAPACITY_END, 0, lineno) != 0) {
+                status = -1;
+            }
+        } else {
+            snprintf(error, error_len, "%s:%d: cannot parse directive %s", path, lineno, tok[0]);
+            status = -1;
+        }
+        s->directives++;
+    }
+    fclose(f);
+    if (status != 0) {
+        scenario_free(s);
+        return -1;
+    }
+
+    qsort(s->events, s->event_count, sizeof(scenario_event_t), compare_events);
+    // A capacity window says which vessel serves; two at once is ambiguous.
+    int vessels = 0;
+    for (int i = 0; i < s->event_count; i++) {
+        if (s->events[i].kind == SCENARIO_CAPACITY_BEGIN && ++vessels > 1) {
+            snprintf(error, error_len, "%s:%d: capacity windows overlap", path, s->events[i].line);
+            scenario_free(s);
+            return -1;
+        }
+        if (s->events[i].kind == SCENARIO_CAPACITY_END) vessels--;
+    }
+    return 0;
+}
+
+// --- LOOKUPS ---
+static double lookup(const scenario_t *s, const float *table, double t) {
+    if (table == NULL) return 1.0;
+    double step = t / s->step_sec;
+    if (step >= s->steps - 1) return table[s->steps - 1];
+    return table[step > 0 ? (int)step : 0];
+}
+
+double scenario_rate(const scenario_t *s, double t) {
+    return lookup(s, s->rate, t);
+}
+
+double scenario_crossing(const scenario_t *s, double t) {
+    return lookup(s, s->crossing, t);
+}
+
+void scenario_free(scenario_t *s) {
+    free(s->events);
+    free(s->rate);
+    free(s->crossing);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,69 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <stddef.h>     // size_t
+
+// --- SCENARIO SCRIPTS ---
+// A scenario script describes how a run changes over time. It is parsed
+// once at startup and compiled into two forms the simulation reads in
+// O(1), without looking at the rules again:
+//
+//   piecewise arrays  the arrival rate and crossing time factors, one
+//                     entry per time step over the whole run. A lookup is
+//                     an index computation. Overlapping windows multiply.
+//   event table       maintenance windows and capacity changes as begin
+//                     and end events sorted by time. The ferry walks it
+//                     with a cursor, so each event is applied once.
+//
+// One directive per line, # starts a comment, times in seconds from the
+// start of the run:
+//   rate F from T1 to T2           cars arrive F times as often (the time
+//                                  ashore is divided by F)
+//   rate F1..F2 from T1 to T2      the same, ramping linearly from F1 to F2
+//   surge F at T for D             rate F from T to T + D
+//   crossing F from T1 to T2       crossings take F times as long (F1..F2
+//                                  ramps too)
+//   maintenance from T1 to T2      the ferry stays out of service
+//   capacity N from T1 to T2       a smaller vessel with N seats serves
+//                                  the route; windows may not overlap
+// The ferry applies events as it starts a cycle, so a cycle under way
+// finishes first, and a window that opens and closes within one cycle
+// has no effect.
+typedef enum {
+    SCENARIO_CAPACITY_END,      // Back to the full capacity
+    SCENARIO_MAINTENANCE_END,
+    SCENARIO_CAPACITY_BEGIN,    // value: seats
+    SCENARIO_MAINTENANCE_BEGIN
+} scenario_event_kind_t;
+
+typedef struct {
+    double at;               // Seconds from the start of the run
+    scenario_event_kind_t kind;
+    int value;
+    int line;                // Script line, for the log
+} scenario_event_t;
+
+#define SCENARIO_MAX_STEPS 65536  // Entries per piecewise array
+#define SCENARIO_MIN_STEP 0.1     // Seconds per entry for short runs
+
+typedef struct {
+    scenario_event_t *events;    // Sorted by time, ends before begins
+    int event_count;
+    float *rate;                 // Arrival rate factor per step
+    float *crossing;             // Crossing time factor per step
+    int steps;
+    double step_sec;
+    int directives;
+} scenario_t;
+
+// Compiles the script at path for a run of runtime_sec seconds on a ferry
+// of max_capacity seats. Returns -1 with a message in error when the
+// script cannot be read or is invalid.
+int scenario_compile(scenario_t *s, const char *path, double runtime_sec, int max_capacity,
+                     char *error, size_t error_len);
+// Factors in effect at t seconds; 1 without a script.
+double scenario_rate(const scenario_t *s, double t);
+double scenario_crossing(const scenario_t *s, double t);
+void scenario_free(scenario_t *s);
+
+#endif
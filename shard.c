@@ -0,0 +1,213 @@
+#define _GNU_SOURCE     // MSG_NOSIGNAL under -std=c99
+
+#include <stdlib.h>     // rand, calloc, free
+#include <string.h>     // memset
+#include <errno.h>      // EINTR
+#include <time.h>       // clock_gettime for send timing
+#include <unistd.h>     // read, close
+#include <poll.h>       // Coordinator wait on every link
+#include <sys/socket.h> // send, MSG_NOSIGNAL
+#include "shard.h"
+
+// --- BYTE ENCODING ---
+static void put_u16(uint8_t *p, uint16_t v) {
+    for (int i = 0; i < 2; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// --- LINKS ---
+void shard_link_init(shard_link_t *link, int fd) {
+    memset(link, 0, sizeof(*link));
+    link->fd = fd;
+    pthread_mutex_init(&link->send_lock, NULL);
+}
+
+void shard_link_close(shard_link_t *link) {
+    if (link->fd >= 0) close(link->fd);
+    link->fd = -1;
+    pthread_mutex_destroy(&link->send_lock);
+}
+
+// A stream socket may take a frame in pieces; MSG_NOSIGNAL turns a peer
+// that has gone away into an error instead of SIGPIPE.
+static int send_all(int fd, const uint8_t *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Returns 1 when len bytes were read, 0 at a clean end of stream before
+// the first byte, -1 on error or a stream cut mid-frame.
+static int read_all(int fd, uint8_t *p, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, p + got, len - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) return got == 0 ? 0 : -1;
+        got += (size_t)n;
+    }
+    return 1;
+}
+
+int shard_send(shard_link_t *link, const shard_msg_t *msg) {
+    uint8_t frame[MSG_HEADER_BYTES + MSG_MAX_VALUES * 8];
+    int count = msg->count < MSG_MAX_VALUES ? msg->count : MSG_MAX_VALUES;
+    put_u16(frame, (uint16_t)msg->type);
+    put_u16(frame + 2, (uint16_t)count);
+    put_u32(frame + 4, (uint32_t)msg->shard);
+    for (int i = 0; i < count; i++) put_u64(frame + MSG_HEADER_BYTES + 8 * i, (uint64_t)msg->v[i]);
+    size_t len = MSG_HEADER_BYTES + 8 * (size_t)count;
+
+    pthread_mutex_lock(&link->send_lock);
+    uint64_t t0 = now_ns();
+    int rc = send_all(link->fd, frame, len);
+    link->send_ns += now_ns() - t0;
+    if (rc == 0) {
+        link->sent++;
+        link->bytes += len;
+    }
+    pthread_mutex_unlock(&link->send_lock);
+    return rc;
+}
+
+int shard_recv(shard_link_t *link, shard_msg_t *msg) {
+    uint8_t frame[MSG_HEADER_BYTES + MSG_MAX_VALUES * 8];
+    int rc = read_all(link->fd, frame, MSG_HEADER_BYTES);
+    if (rc <= 0) return rc;
+    msg->type = get_u16(frame);
+    msg->count = get_u16(frame + 2);
+    msg->shard = (int)get_u32(frame + 4);
+    if (msg->count > MSG_MAX_VALUES) return -1;
+    if (read_all(link->fd, frame + MSG_HEADER_BYTES, 8 * (size_t)msg->count) != 1) return -1;
+    for (int i = 0; i < msg->count; i++) {
+        msg->v[i] = (int64_t)get_u64(frame + MSG_HEADER_BYTES + 8 * i);
+    }
+    link->received++;
+    link->bytes += MSG_HEADER_BYTES + 8 * (size_t)msg->count;
+    return 1;
+}
+
+// --- COORDINATOR ---
+// Picks the destination of a transfer from src: a random live shard other
+// than src with a parked car thread, else src itself (whose sender thread
+// is parked by then). -1 when there is none.
+static int route(int src, int shards, const int *alive, const long *parked) {
+    int candidates = 0;
+    for (int s = 0; s < shards; s++) {
+        if (s != src && alive[s] && parked[s] > 0) candidates++;
+    }
+    if (candidates > 0) {
+        int pick = rand() % candidates;
+        for (int s = 0; s < shards; s++) {
+            if (s != src && alive[s] && parked[s] > 0 && pick-- == 0) return s;
+        }
+    }
+    return alive[src] && parked[src] > 0 ? src : -1;
+}
+
+void shard_coordinate(shard_link_t *links, int shards, int64_t (*clock_us)(void),
+                      int64_t (*stats)[SHARD_STATS_VALUES], int *finished,
+                      coordinator_stats_t *out) {
+    struct pollfd *pfds = calloc(shards, sizeof(struct pollfd));
+    int *alive = calloc(shards, sizeof(int));
+    long *parked = calloc(shards, sizeof(long));
+    memset(out, 0, sizeof(*out));
+    if (pfds == NULL || alive == NULL || parked == NULL) {
+        free(pfds); free(alive); free(parked);
+        return;
+    }
+    int live = shards;
+    for (int s = 0; s < shards; s++) {
+        alive[s] = 1;
+        finished[s] = 0;
+        pfds[s].fd = links[s].fd;
+        pfds[s].events = POLLIN;
+    }
+
+    while (live > 0) {
+        if (poll(pfds, shards, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int s = 0; s < shards; s++) {
+            if (!alive[s] || pfds[s].revents == 0) continue;
+            shard_msg_t msg;
+            if (shard_recv(&links[s], &msg) != 1) {
+                // Hung up (or garbled) without reporting: stop routing to it.
+                alive[s] = 0;
+                pfds[s].fd = -1;
+                live--;
+                continue;
+            }
+            switch (msg.type) {
+            case MSG_TRANSFER: {
+                parked[s]++;
+                int dst = route(s, shards, alive, parked);
+                msg.shard = s;
+                if (dst >= 0 && shard_send(&links[dst], &msg) == 0) {
+                    parked[dst]--;
+                    out->routed++;
+                } else {
+                    out->dropped++;
+                }
+                break;
+            }
+            case MSG_TIME_PING: {
+                shard_msg_t pong = { MSG_TIME_PONG, s, 2, { msg.v[0], clock_us() } };
+                shard_send(&links[s], &pong);
+                out->pings++;
+                break;
+            }
+            case MSG_STATS:
+                for (int i = 0; i < SHARD_STATS_VALUES; i++) {
+                    stats[s][i] = i < msg.count ? msg.v[i] : 0;
+                }
+                finished[s] = 1;
+                alive[s] = 0;
+                pfds[s].fd = -1;
+                live--;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    free(pfds);
+    free(alive);
+    free(parked);
+}
@@ -0,0 +1,95 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <stdint.h>     // Fixed-width message fields
+#include <pthread.h>    // Send lock of a link
+
+// --- SHARD MESSAGES ---
+// A sharded run splits the cars across shard processes, each simulating
+// its own dock with its own memory, plus a coordinator that routes car
+// transfers between them and serves as the reference clock. Every shard
+// talks only to the coordinator, over one stream socket, so the same
+// protocol runs over TCP once shards live on different nodes.
+//
+// Frame: u16 type, u16 value count, u32 shard, then count signed 64-bit
+// values, all little-endian. Frames are fixed by their header, so a
+// reader needs no delimiter and any byte stream works as a transport.
+// Shards keep their own clocks; time pings estimate each one's offset to
+// the coordinator's, and timestamps that cross shards are sent in the
+// coordinator's timebase.
+typedef enum {
+    MSG_TRANSFER = 1,   // car_id, sent_at_us (coordinator clock, via the offset)
+    MSG_TIME_PING,      // sent_at_us (shard clock)
+    MSG_TIME_PONG,      // sent_at_us (echoed), coordinator_us
+    MSG_STATS           // SHARD_STATS_* values, the shard's last message
+} msg_type_t;
+
+#define MSG_MAX_VALUES 16
+#define MSG_HEADER_BYTES 8
+
+typedef struct {
+    int type;
+    int shard;                     // Sender (to the coordinator) or source shard
+    int count;                     // Values used
+    int64_t v[MSG_MAX_VALUES];
+} shard_msg_t;
+
+// Values of a MSG_STATS message.
+enum {
+    SHARD_STATS_DEPARTURES,
+    SHARD_STATS_JOURNEYS,
+    SHARD_STATS_RUN_US,
+    SHARD_STATS_TRANSFERS_OUT,
+    SHARD_STATS_TRANSFERS_IN,
+    SHARD_STATS_TRANSFER_WAIT_US,  // Sum over transfers in of send-to-adopt time
+    SHARD_STATS_MSGS_SENT,         // Not counting this message
+    SHARD_STATS_MSGS_RECEIVED,
+    SHARD_STATS_BYTES,             // Sent and received
+    SHARD_STATS_SEND_NS,           // Time spent inside sends
+    SHARD_STATS_PINGS,             // Answered time pings
+    SHARD_STATS_RTT_US,            // Sum of ping round trips
+    SHARD_STATS_OFFSET_US,         // Last estimated coordinator - shard offset
+    SHARD_STATS_VIOLATIONS,
+    SHARD_STATS_VALUES
+};
+
+// --- LINKS ---
+// One end of a shard <-> coordinator connection. Sends are serialized by
+// the link's lock (car threads and the main thread share it); only one
+// thread may receive.
+typedef struct {
+    int fd;
+    pthread_mutex_t send_lock;
+    unsigned long sent, received;  // Messages
+    uint64_t bytes;                // Sent and received
+    uint64_t send_ns;              // Time spent inside sends
+} shard_link_t;
+
+void shard_link_init(shard_link_t *link, int fd);
+void shard_link_close(shard_link_t *link);
+
+// Returns 0, or -1 when the peer is gone.
+int shard_send(shard_link_t *link, const shard_msg_t *msg);
+
+// Returns 1 with a message, 0 at end of stream, -1 on a malformed frame.
+int shard_recv(shard_link_t *link, shard_msg_t *msg);
+
+// --- COORDINATOR ---
+// Serves shards until every one has sent its MSG_STATS or hung up:
+// answers time pings with clock_us(), and routes each transfer to a shard
+// that has a car thread waiting for one (a shard parks the thread of every
+// car it sends away), preferring any shard but the sender. A transfer with
+// nowhere to go (every other shard has finished) is dropped.
+// stats receives SHARD_STATS_VALUES values per shard; finished[s] is set
+// for shards that reported.
+typedef struct {
+    unsigned long routed;          // Transfers forwarded
+    unsigned long dropped;         // Transfers with no live destination
+    unsigned long pings;
+} coordinator_stats_t;
+
+void shard_coordinate(shard_link_t *links, int shards, int64_t (*clock_us)(void),
+                      int64_t (*stats)[SHARD_STATS_VALUES], int *finished,
+                      coordinator_stats_t *out);
+
+#endif
@@ -0,0 +1,409 @@
+#define _GNU_SOURCE     // mmap flags and pwrite under -std=c99
+
+#include <stdio.h>      // fprintf for fallback notices
+#include <string.h>     // memcpy, memset
+#include <unistd.h>     // write, pwrite, close
+#include <errno.h>      // EINTR
+#include <fcntl.h>      // open
+#include <stdint.h>     // uint64_t
+#include <stdbool.h>    // Boolean Type
+#include <pthread.h>    // Sink mutex
+#include <sys/stat.h>   // fstat, S_ISREG
+#include <sys/mman.h>   // Staging buffers and ring mappings
+#include <sys/uio.h>    // struct iovec
+#ifdef __linux__
+#include <sys/syscall.h>      // io_uring has no libc wrapper
+#include <linux/io_uring.h>   // Ring layout and opcodes
+#endif
+#include "sink.h"
+
+static sink_kind_t sink_kind = SINK_WRITE;
+static int sink_fd = STDOUT_FILENO;
+static bool sink_owns_fd = false;
+static unsigned long syscalls = 0;
+
+const char *sink_kind_name(sink_kind_t kind) {
+    switch (kind) {
+    case SINK_URING: return "io_uring";
+    case SINK_MMAP:  return "mmap";
+    default:         return "write";
+    }
+}
+
+unsigned long sink_syscalls(void) {
+    return __atomic_load_n(&syscalls, __ATOMIC_RELAXED);
+}
+
+// --- WRITE SINK ---
+// Writes the whole range at the current file position, retrying on short
+// writes and interrupts.
+static void write_fully(const char *data, size_t len) {
+    while (len > 0) {
+        __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+        ssize_t n = write(sink_fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+// Same as write_fully, at an explicit offset (used after short io_uring writes).
+static void pwrite_fully(const char *data, size_t len, off_t offset) {
+    while (len > 0) {
+        __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+        ssize_t n = pwrite(sink_fd, data, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        data += n;
+        offset += n;
+        len -= (size_t)n;
+    }
+}
+
+// --- IO_URING SINK ---
+#ifdef __linux__
+#define URING_ENTRIES 8
+
+// Userspace view of the submission and completion rings.
+typedef struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring, *cq_ring;
+    size_t sq_ring_len, cq_ring_len, sqes_len;
+    bool fixed_buffers;     // Staging buffers registered with the kernel
+} uring_t;
+
+static uring_t ring;
+static pthread_mutex_t uring_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Double buffer: one buffer fills while the other is in flight.
+static char *stage[2];
+static size_t stage_used[2];
+static bool stage_busy[2];
+static off_t stage_offset[2];   // File offset each in-flight write targets
+static int active_stage = 0;
+static off_t file_offset = 0;   // Where the next staged buffer goes
+
+static int uring_enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+    return (int)syscall(__NR_io_uring_enter, ring.fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static void uring_teardown(void);
+
+static int uring_setup(void) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // Nothing mapped yet, so a failure below unmaps only what it got to.
+    ring.sq_ring = ring.cq_ring = NULL;
+    ring.sqes = NULL;
+    stage[0] = stage[1] = NULL;
+    ring.fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (ring.fd < 0) return -1;
+
+    ring.sq_ring_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cq_ring_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring.cq_ring_len > ring.sq_ring_len) ring.sq_ring_len = ring.cq_ring_len;
+        ring.cq_ring_len = ring.sq_ring_len;
+    }
+
+    ring.sq_ring = mmap(NULL, ring.sq_ring_len, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if (ring.sq_ring == MAP_FAILED) goto fail;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring.cq_ring = ring.sq_ring;
+    } else {
+        ring.cq_ring = mmap(NULL, ring.cq_ring_len, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+        if (ring.cq_ring == MAP_FAILED) goto fail;
+    }
+    ring.sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring.sqes = mmap(NULL, ring.sqes_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (ring.sqes == MAP_FAILED) goto fail;
+
+    char *sq = ring.sq_ring, *cq = ring.cq_ring;
+    ring.sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring.sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring.cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring.cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    // Page-aligned staging buffers, registered so the kernel can skip
+    // pinning them on every write. Registration is optional.
+    for (int i = 0; i < 2; i++) {
+        stage[i] = mmap(NULL, SINK_STAGE_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (stage[i] == MAP_FAILED) { stage[i] = NULL; goto fail; }
+        stage_used[i] = 0;
+        stage_busy[i] = false;
+    }
+    struct iovec iov[2] = {
+        { stage[0], SINK_STAGE_SIZE }, { stage[1], SINK_STAGE_SIZE }
+    };
+    ring.fixed_buffers =
+        syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_BUFFERS, iov, 2) == 0;
+    active_stage = 0;
+    file_offset = 0;
+    return 0;
+
+fail:
+    uring_teardown();
+    return -1;
+}
+
+static void unmap_if_mapped(void *addr, size_t len) {
+    if (addr != NULL && addr != MAP_FAILED) munmap(addr, len);
+}
+
+// Also undoes a partial uring_setup().
+static void uring_teardown(void) {
+    unmap_if_mapped(ring.sqes, ring.sqes_len);
+    if (ring.cq_ring != ring.sq_ring) unmap_if_mapped(ring.cq_ring, ring.cq_ring_len);
+    unmap_if_mapped(ring.sq_ring, ring.sq_ring_len);
+    close(ring.fd);
+    ring.fd = -1;
+    ring.sq_ring = ring.cq_ring = NULL;
+    ring.sqes = NULL;
+    for (int i = 0; i < 2; i++) {
+        if (stage[i] != NULL) munmap(stage[i], SINK_STAGE_SIZE);
+        stage[i] = NULL;
+    }
+}
+
+// Waits for one completion and retires its staging buffer. A short
+// write is finished synchronously so no bytes are lost.
+static void uring_reap(void) {
+    unsigned head = *ring.cq_head;
+    while (head == __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+        uring_enter(0, 1, IORING_ENTER_GETEVENTS);
+    }
+
+    struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+    int idx = (int)cqe->user_data;
+    size_t done = cqe->res > 0 ? (size_t)cqe->res : 0;
+    __atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+
+    if (done < stage_used[idx]) {
+        pwrite_fully(stage[idx] + done, stage_used[idx] - done, stage_offset[idx] + done);
+    }
+    stage_used[idx] = 0;
+    stage_busy[idx] = false;
+}
+
+// Submits the active staging buffer and switches to the other one,
+// waiting for it first if its previous write is still in flight.
+static void uring_submit_active(void) {
+    int idx = active_stage;
+    if (stage_used[idx] == 0) return;
+
+    unsigned tail = *ring.sq_tail;
+    unsigned slot = tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = ring.fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = sink_fd;
+    sqe->addr = (uint64_t)(uintptr_t)stage[idx];
+    sqe->len = (unsigned)stage_used[idx];
+    sqe->off = (uint64_t)file_offset;
+    sqe->buf_index = (uint16_t)idx;
+    sqe->user_data = (uint64_t)idx;
+    ring.sq_array[slot] = slot;
+    __atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    stage_busy[idx] = true;
+    stage_offset[idx] = file_offset;
+    file_offset += (off_t)stage_used[idx];
+    uring_enter(1, 0, 0);
+
+    active_stage ^= 1;
+    while (stage_busy[active_stage]) uring_reap();
+}
+
+static void uring_write(const char *data, size_t len) {
+    pthread_mutex_lock(&uring_lock);
+    while (len > 0) {
+        int idx = active_stage;
+        size_t room = SINK_STAGE_SIZE - stage_used[idx];
+        size_t chunk = len < room ? len : room;
+        memcpy(stage[idx] + stage_used[idx], data, chunk);
+        stage_used[idx] += chunk;
+        data += chunk;
+        len -= chunk;
+        if (stage_used[idx] == SINK_STAGE_SIZE) uring_submit_active();
+    }
+    pthread_mutex_unlock(&uring_lock);
+}
+
+static void uring_close(void) {
+    pthread_mutex_lock(&uring_lock);
+    uring_submit_active();
+    for (int i = 0; i < 2; i++) {
+        while (stage_busy[i]) uring_reap();
+    }
+    pthread_mutex_unlock(&uring_lock);
+    uring_teardown();
+}
+#endif
+
+// --- MMAP SINK ---
+// The whole reserve is mapped once, so the mapping never moves while other
+// threads copy into it; only the file behind it grows.
+static char *map_base = NULL;
+static size_t map_reserved = 0;
+static size_t map_cursor = 0;      // Next free byte (atomic)
+static size_t map_committed = 0;   // Current file length (atomic)
+static size_t map_written_end = 0; // End of the furthest record copied in (atomic)
+static size_t map_dropped = 0;     // Bytes of records that did not fit (atomic)
+static int map_failed = 0;         // Set on the first dropped record (atomic)
+static pthread_mutex_t map_grow_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int mmap_setup(void) {
+    int flags = MAP_SHARED;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+    if (ftruncate(sink_fd, SINK_MMAP_INITIAL) != 0) return -1;
+    map_base = mmap(NULL, SINK_MMAP_RESERVE, PROT_READ | PROT_WRITE, flags, sink_fd, 0);
+    if (map_base == MAP_FAILED) {
+        map_base = NULL;
+        return -1;
+    }
+    map_reserved = SINK_MMAP_RESERVE;
+    map_cursor = 0;
+    map_committed = SINK_MMAP_INITIAL;
+    map_written_end = 0;
+    map_dropped = 0;
+    map_failed = 0;
+    return 0;
+}
+
+// Makes sure the file covers [0, end). Only the slow path takes the lock.
+static bool mmap_commit(size_t end) {
+    if (end <= __atomic_load_n(&map_committed, __ATOMIC_ACQUIRE)) return true;
+    if (end > map_reserved) return false;
+
+    pthread_mutex_lock(&map_grow_lock);
+    size_t size = map_committed;
+    if (size < end) {
+        while (size < end) size *= 2;
+        if (size > map_reserved) size = map_reserved;
+        __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+        if (ftruncate(sink_fd, (off_t)size) == 0) {
+            __atomic_store_n(&map_committed, size, __ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&map_grow_lock);
+    return end <= __atomic_load_n(&map_committed, __ATOMIC_ACQUIRE);
+}
+
+// Once a record is dropped (reserve exhausted, or the file could not
+// grow), every later one is dropped too, so the file stays a prefix of
+// the log without holes.
+static void mmap_write(const char *data, size_t len) {
+    size_t off = __atomic_fetch_add(&map_cursor, len, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&map_failed, __ATOMIC_RELAXED) || !mmap_commit(off + len)) {
+        __atomic_store_n(&map_failed, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&map_dropped, len, __ATOMIC_RELAXED);
+        return;
+    }
+    memcpy(map_base + off, data, len);
+    size_t end = __atomic_load_n(&map_written_end, __ATOMIC_RELAXED);
+    while (end < off + len &&
+           !__atomic_compare_exchange_n(&map_written_end, &end, off + len, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Trims the file to the end of the last record copied in; reserved space
+// of dropped records is not left behind as a NUL-filled tail.
+static void mmap_close(void) {
+    size_t length = __atomic_load_n(&map_written_end, __ATOMIC_RELAXED);
+    size_t dropped = __atomic_load_n(&map_dropped, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        fprintf(stderr, "mmap sink: dropped %zu log bytes past %zu (reserve or file growth exhausted)\n",
+                dropped, length);
+    }
+    msync(map_base, length, MS_ASYNC);
+    munmap(map_base, map_reserved);
+    map_base = NULL;
+    __atomic_fetch_add(&syscalls, 1, __ATOMIC_RELAXED);
+    if (ftruncate(sink_fd, (off_t)length) != 0) perror("ftruncate");
+}
+
+// --- SINK INTERFACE ---
+int sink_open(sink_kind_t kind, const char *path) {
+    sink_fd = STDOUT_FILENO;
+    sink_owns_fd = false;
+    if (path != NULL) {
+        // The mmap sink needs read access to map the file shared.
+        int flags = (kind == SINK_MMAP ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC |
+                    (kind == SINK_WRITE ? O_APPEND : 0);
+        sink_fd = open(path, flags, 0644);
+        if (sink_fd < 0) return -1;
+        sink_owns_fd = true;
+    }
+
+    sink_kind = SINK_WRITE;
+    if (kind == SINK_URING) {
+#ifdef __linux__
+        struct stat st;
+        // Requires a file we own: stdout may be shared with other writers
+        // that do not know about the offsets io_uring writes at.
+        if (sink_owns_fd && fstat(sink_fd, &st) == 0 && S_ISREG(st.st_mode) &&
+            uring_setup() == 0) {
+            sink_kind = SINK_URING;
+        }
+#endif
+        if (sink_kind != SINK_URING) {
+            fprintf(stderr, "io_uring sink unavailable for this output, using write()\n");
+        }
+    } else if (kind == SINK_MMAP) {
+        struct stat st;
+        if (sink_owns_fd && fstat(sink_fd, &st) == 0 && S_ISREG(st.st_mode) &&
+            mmap_setup() == 0) {
+            sink_kind = SINK_MMAP;
+        } else {
+            fprintf(stderr, "mmap sink needs a regular log file, using write()\n");
+        }
+    }
+    return sink_kind;
+}
+
+void sink_write(const char *data, size_t len) {
+    if (sink_kind == SINK_MMAP) {
+        mmap_write(data, len);
+        return;
+    }
+#ifdef __linux__
+    if (sink_kind == SINK_URING) {
+        uring_write(data, len);
+        return;
+    }
+#endif
+    write_fully(data, len);
+}
+
+void sink_close(void) {
+    if (sink_kind == SINK_MMAP) mmap_close();
+#ifdef __linux__
+    if (sink_kind == SINK_URING) uring_close();
+#endif
+    if (sink_owns_fd) close(sink_fd);
+    sink_fd = STDOUT_FILENO;
+    sink_owns_fd = false;
+    sink_kind = SINK_WRITE;
+}
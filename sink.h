@@ -0,0 +1,48 @@
+#ifndef SINK_H
+#define SINK_H
+
+#include <stddef.h>     // size_t
+
+// --- OUTPUT SINKS ---
+// Final destination of the log bytes produced by the log module.
+// SINK_WRITE issues a plain write() per chunk. SINK_URING copies chunks
+// into one of two registered staging buffers and submits large aligned
+// writes through io_uring, so formatting continues while the previous
+// buffer is being written. Only a regular file opened by the sink can use
+// io_uring; anything else (stdout, a pipe, a non-Linux system) falls back
+// to SINK_WRITE.
+//
+// SINK_MMAP maps the log file shared and lets every thread reserve its
+// region with one atomic add on a cursor, then copy its bytes straight
+// into the mapping: no lock and no system call per write. The file is
+// grown ahead of the cursor (doubling) and trimmed to the exact length on
+// close. Should the reserve run out, the records past it are dropped, and
+// the dropped bytes are reported on close. Other processes may read it while it is written; bytes that are
+// reserved but not yet copied read as NUL, so live readers should stop at
+// the first NUL byte.
+typedef enum {
+    SINK_WRITE,
+    SINK_URING,
+    SINK_MMAP
+} sink_kind_t;
+
+#define SINK_STAGE_SIZE (1024 * 1024)          // Bytes per io_uring staging buffer
+#define SINK_MMAP_INITIAL (16L * 1024 * 1024)  // Initial mmap log file size
+#define SINK_MMAP_RESERVE (64L << 30)          // Address space reserved for growth
+
+// Opens the sink on path (truncating it), or on stdout when path is NULL.
+// Returns the kind actually in use, or -1 when the file cannot be opened.
+int sink_open(sink_kind_t kind, const char *path);
+
+// Appends bytes to the output. Safe to call from any thread.
+void sink_write(const char *data, size_t len);
+
+// Writes out staged bytes, waits for outstanding I/O and closes the file.
+void sink_close(void);
+
+const char *sink_kind_name(sink_kind_t kind);
+
+// System calls issued for output (write(), io_uring_enter() or ftruncate()).
+unsigned long sink_syscalls(void);
+
+#endif
@@ -0,0 +1,272 @@
+#define _GNU_SOURCE     // syscall, sched_yield under -std=c99
+
+#include <string.h>     // strcmp, strncpy
+#include <fcntl.h>      // O_CREAT
+#include <sched.h>      // sched_yield
+#include <time.h>       // Futex wait timeout
+#ifdef __linux__
+#include <unistd.h>             // syscall
+#include <sys/syscall.h>        // SYS_futex
+#include <linux/futex.h>        // FUTEX_WAIT, FUTEX_WAKE and their _PRIVATE forms
+#include <sys/eventfd.h>        // eventfd, EFD_SEMAPHORE
+#include <poll.h>               // Blocking wait on the non-blocking eventfd
+#include <errno.h>              // EAGAIN
+#include <stdint.h>             // uint64_t eventfd counter
+#endif
+#include "sync.h"
+
+// Longest a futex waiter sleeps before checking for cancellation.
+#define SYNC_CANCEL_POLL_NS (50 * 1000 * 1000)
+// Spins before a spin waiter starts yielding its core.
+#define SYNC_SPIN_LIMIT 128
+
+static const char *backend_names[SYNC_BACKENDS] = {
+    "named", "unnamed", "condvar", "futex", "spin", "eventfd"
+};
+
+const char *sync_backend_name(sync_backend_t backend) {
+    return backend < SYNC_BACKENDS ? backend_names[backend] : "unknown";
+}
+
+int sync_backend_parse(const char *name) {
+    for (int b = 0; b < SYNC_BACKENDS; b++) {
+        if (strcmp(name, backend_names[b]) == 0) return b;
+    }
+    return -1;
+}
+
+// --- COUNTER HELPERS ---
+// Takes one permit if there is one.
+static int try_take(sync_sem_t *s) {
+    int c = __atomic_load_n(&s->count, __ATOMIC_ACQUIRE);
+    while (c > 0) {
+        if (__atomic_compare_exchange_n(&s->count, &c, c - 1, 1,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) return 1;
+    }
+    return 0;
+}
+
+static void unlock_mutex(void *lock) {
+    pthread_mutex_unlock(lock);
+}
+
+#ifdef __linux__
+// The eventfd is non-blocking so that sync_trywait can share it; a blocked
+// wait sleeps in poll (a cancellation point) and retries the read, since
+// another waiter may take the permit between the wakeup and the read.
+static int eventfd_take(sync_sem_t *s) {
+    uint64_t one;
+    return read(s->fd, &one, sizeof(one)) == (ssize_t)sizeof(one);
+}
+#endif
+
+// --- BACKEND DISPATCH ---
+int sync_init(sync_sem_t *s, sync_backend_t backend, const char *name, int pshared) {
+    memset(s, 0, sizeof(*s));
+    s->backend = backend;
+    s->pshared = pshared;
+    switch (backend) {
+    case SYNC_NAMED:
+        // Unlink first to clean up leftovers of a previous run. O_CREAT
+        // creates the semaphore; 0644 gives read/write to the owner.
+        strncpy(s->name, name, SYNC_NAME_LEN - 1);
+        sem_unlink(s->name);
+        s->named = sem_open(s->name, O_CREAT, 0644, 0);
+        return s->named == SEM_FAILED ? -1 : 0;
+    case SYNC_UNNAMED:
+        return sem_init(&s->unnamed, pshared, 0);
+    case SYNC_CONDVAR: {
+        pthread_mutexattr_t mattr;
+        pthread_condattr_t cattr;
+        pthread_mutexattr_init(&mattr);
+        pthread_condattr_init(&cattr);
+        if (pshared) {
+            pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+            pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+        }
+        int rc = pthread_mutex_init(&s->lock, &mattr) | pthread_cond_init(&s->cond, &cattr);
+        pthread_mutexattr_destroy(&mattr);
+        pthread_condattr_destroy(&cattr);
+        return rc == 0 ? 0 : -1;
+    }
+    case SYNC_FUTEX:
+#ifdef __linux__
+        return 0;
+#else
+        return -1;
+#endif
+    case SYNC_SPIN:
+        return 0;
+    case SYNC_EVENTFD:
+#ifdef __linux__
+        s->fd = eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC);
+        return s->fd < 0 ? -1 : 0;
+#else
+        return -1;
+#endif
+    }
+    return -1;
+}
+
+void sync_post(sync_sem_t *s) {
+    switch (s->backend) {
+    case SYNC_NAMED:
+        sem_post(s->named);
+        break;
+    case SYNC_UNNAMED:
+        sem_post(&s->unnamed);
+        break;
+    case SYNC_CONDVAR:
+        pthread_mutex_lock(&s->lock);
+        s->count++;
+        pthread_cond_signal(&s->cond);
+        pthread_mutex_unlock(&s->lock);
+        break;
+    case SYNC_FUTEX:
+#ifdef __linux__
+        // Sequentially consistent on both sides: either the waiter sees the
+        // permit before sleeping, or this post sees the waiter and wakes it.
+        __atomic_fetch_add(&s->count, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&s->waiters, __ATOMIC_SEQ_CST) > 0) {
+            syscall(SYS_futex, &s->count, s->pshared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE,
+                    1, NULL, NULL, 0);
+        }
+#endif
+        break;
+    case SYNC_SPIN:
+        __atomic_fetch_add(&s->count, 1, __ATOMIC_RELEASE);
+        break;
+    case SYNC_EVENTFD:
+#ifdef __linux__
+    {
+        uint64_t one = 1;
+        ssize_t written = write(s->fd, &one, sizeof(one));
+        (void)written;  // Fails only if the counter would overflow
+    }
+#endif
+        break;
+    }
+}
+
+void sync_wait(sync_sem_t *s) {
+    switch (s->backend) {
+    case SYNC_NAMED:
+        sem_wait(s->named);
+        break;
+    case SYNC_UNNAMED:
+        sem_wait(&s->unnamed);
+        break;
+    case SYNC_CONDVAR:
+        pthread_mutex_lock(&s->lock);
+        // pthread_cond_wait is a cancellation point that returns with the
+        // mutex held, so a cancelled waiter must release it on the way out.
+        pthread_cleanup_push(unlock_mutex, &s->lock);
+        while (s->count == 0) pthread_cond_wait(&s->cond, &s->lock);
+        s->count--;
+        pthread_cleanup_pop(1);
+        break;
+    case SYNC_FUTEX:
+#ifdef __linux__
+        while (!try_take(s)) {
+            pthread_testcancel();
+            struct timespec poll = { 0, SYNC_CANCEL_POLL_NS };
+            __atomic_fetch_add(&s->waiters, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&s->count, __ATOMIC_SEQ_CST) == 0) {
+                syscall(SYS_futex, &s->count, s->pshared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE,
+                        0, &poll, NULL, 0);
+            }
+            __atomic_fetch_sub(&s->waiters, 1, __ATOMIC_SEQ_CST);
+        }
+#endif
+        break;
+    case SYNC_SPIN:
+        for (unsigned long spins = 0; !try_take(s); spins++) {
+            if (spins < SYNC_SPIN_LIMIT) {
+                CPU_RELAX();
+            } else {
+                pthread_testcancel();
+                sched_yield();
+            }
+        }
+        break;
+    case SYNC_EVENTFD:
+#ifdef __linux__
+        while (!eventfd_take(s)) {
+            struct pollfd pfd = { s->fd, POLLIN, 0 };
+            if (errno == EAGAIN) poll(&pfd, 1, -1);
+        }
+#endif
+        break;
+    }
+}
+
+int sync_trywait(sync_sem_t *s) {
+    int taken = 0;
+    switch (s->backend) {
+    case SYNC_NAMED:
+        taken = sem_trywait(s->named) == 0;
+        break;
+    case SYNC_UNNAMED:
+        taken = sem_trywait(&s->unnamed) == 0;
+        break;
+    case SYNC_CONDVAR:
+        pthread_mutex_lock(&s->lock);
+        if (s->count > 0) {
+            s->count--;
+            taken = 1;
+        }
+        pthread_mutex_unlock(&s->lock);
+        break;
+    case SYNC_FUTEX:
+    case SYNC_SPIN:
+        taken = try_take(s);
+        break;
+    case SYNC_EVENTFD:
+#ifdef __linux__
+        taken = eventfd_take(s);
+#endif
+        break;
+    }
+    return taken;
+}
+
+int sync_value(sync_sem_t *s) {
+    int value = -1;
+    switch (s->backend) {
+    case SYNC_NAMED:
+        if (sem_getvalue(s->named, &value) != 0) value = -1;
+        break;
+    case SYNC_UNNAMED:
+        if (sem_getvalue(&s->unnamed, &value) != 0) value = -1;
+        break;
+    case SYNC_EVENTFD:
+        break;  // Reading the counter would consume it
+    default:
+        value = __atomic_load_n(&s->count, __ATOMIC_RELAXED);
+        break;
+    }
+    return value;
+}
+
+void sync_destroy(sync_sem_t *s) {
+    switch (s->backend) {
+    case SYNC_NAMED:
+        sem_close(s->named);
+        sem_unlink(s->name);
+        break;
+    case SYNC_UNNAMED:
+        sem_destroy(&s->unnamed);
+        break;
+    case SYNC_CONDVAR:
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->lock);
+        break;
+    case SYNC_EVENTFD:
+#ifdef __linux__
+        close(s->fd);
+#endif
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <pthread.h>    // Mutex and condition variable backend
+#include <semaphore.h>  // Named and unnamed semaphore backends
+
+// --- SYNCHRONIZATION BACKENDS ---
+// The ferry and the cars hand permits to each other through four counting
+// semaphores. Every backend below implements the same post/wait contract,
+// so the protocol (and the invariant checker watching it) stays the same
+// while the primitive underneath changes:
+//   named    sem_open, the original implementation (works on macOS)
+//   unnamed  sem_init, no file system name (not on macOS)
+//   condvar  counter under a mutex, pthread_cond_signal on post
+//   futex    atomic counter, FUTEX_WAKE only when someone sleeps (Linux)
+//   spin     atomic counter, waiters spin and then yield
+//   eventfd  EFD_SEMAPHORE counter in the kernel, one read per permit (Linux)
+// Waits are cancellation points on every backend; the futex and spin
+// backends poll for cancellation because their waits are not.
+//
+// A semaphore created with pshared set works between processes when it
+// lives in shared memory: the unnamed and condvar backends use process-
+// shared objects and the futex backend the shared (non-private) futex
+// operations. A named semaphore or an eventfd is shared by forking.
+typedef enum {
+    SYNC_NAMED,
+    SYNC_UNNAMED,
+    SYNC_CONDVAR,
+    SYNC_FUTEX,
+    SYNC_SPIN,
+    SYNC_EVENTFD
+} sync_backend_t;
+
+#define SYNC_BACKENDS 6
+#define SYNC_NAME_LEN 32
+
+// Pause hint for spin loops.
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX() do { } while (0)
+#endif
+
+typedef struct {
+    sync_backend_t backend;
+    char name[SYNC_NAME_LEN];  // sem_open name (named backend)
+    sem_t *named;
+    sem_t unnamed;
+    pthread_mutex_t lock;      // condvar backend
+    pthread_cond_t cond;
+    int count;                 // Permits (condvar, futex and spin backends)
+    int waiters;               // Threads asleep in FUTEX_WAIT
+    int fd;                    // eventfd backend
+    int pshared;               // Usable from several processes
+} sync_sem_t;
+
+const char *sync_backend_name(sync_backend_t backend);
+int sync_backend_parse(const char *name);  // -1 when unknown
+
+// Creates a semaphore with no permits. name is only used by the named
+// backend. Returns -1 when the backend is unavailable on this system.
+int sync_init(sync_sem_t *s, sync_backend_t backend, const char *name, int pshared);
+void sync_post(sync_sem_t *s);
+void sync_wait(sync_sem_t *s);
+int sync_trywait(sync_sem_t *s);  // Takes a permit if one is free; 1 on success
+int sync_value(sync_sem_t *s);   // Current permits, -1 when unknown (eventfd)
+void sync_destroy(sync_sem_t *s);
+
+#endif
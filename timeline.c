@@ -0,0 +1,157 @@
+#include <string.h>     // memcmp
+#include <pthread.h>    // Writer lock
+#include "pool.h"       // counted_malloc, counted_free
+#include "timeline.h"
+
+#define TIMELINE_BUFFER_SIZE (1024 * 1024) // stdio buffer of the writer
+
+const char *timeline_kind_name(int kind) {
+    switch (kind) {
+    case TL_BOARDING:     return "boarding";
+    case TL_WAITING_FULL: return "waiting_full";
+    case TL_CROSSING:     return "crossing";
+    case TL_UNBOARDING:   return "unboarding";
+    case TL_SEAT:         return "seat";
+    default:              return "unknown";
+    }
+}
+
+// --- BYTE ENCODING ---
+static void put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static size_t put_varint(uint8_t *p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Reads a varint from the stream. Returns 1, or -1 when it is truncated.
+static int read_varint(FILE *f, uint64_t *v) {
+    *v = 0;
+    for (int n = 0; n < 10; n++) {
+        int c = getc(f);
+        if (c == EOF) return -1;
+        *v |= (uint64_t)(c & 0x7f) << (7 * n);
+        if ((c & 0x80) == 0) return 1;
+    }
+    return -1;
+}
+
+// --- WRITER ---
+// Intervals are encoded straight into a large stdio buffer; the file is
+// written in big chunks and never read back by the simulator.
+static FILE *out = NULL;
+static char *out_buffer = NULL;
+static int64_t last_start_us = 0;
+static pthread_mutex_t timeline_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int timeline_open(const char *path, int lanes) {
+    out = fopen(path, "wb");
+    if (out == NULL) return -1;
+    out_buffer = counted_malloc(TIMELINE_BUFFER_SIZE);
+    if (out_buffer != NULL) setvbuf(out, out_buffer, _IOFBF, TIMELINE_BUFFER_SIZE);
+
+    uint8_t header[12];
+    memcpy(header, TIMELINE_MAGIC, 8);
+    put_u32(header + 8, (uint32_t)lanes);
+    last_start_us = 0;
+    return fwrite(header, 1, sizeof(header), out) == sizeof(header) ? 0 : -1;
+}
+
+void timeline_interval(int kind, int lane, int car_id, double start_sec, double end_sec) {
+    if (out == NULL) return;
+    int64_t start = (int64_t)(start_sec * 1e6);
+    int64_t end = (int64_t)(end_sec * 1e6);
+    if (end < start) end = start;
+
+    uint8_t rec[TIMELINE_MAX_RECORD];
+    pthread_mutex_lock(&timeline_lock);
+    size_t n = 0;
+    rec[n++] = (uint8_t)kind;
+    n += put_varint(rec + n, (uint64_t)lane);
+    n += put_varint(rec + n, zigzag(car_id));
+    n += put_varint(rec + n, zigzag(start - last_start_us));
+    n += put_varint(rec + n, (uint64_t)(end - start));
+    last_start_us = start;
+    fwrite(rec, 1, n, out);
+    pthread_mutex_unlock(&timeline_lock);
+}
+
+void timeline_close(void) {
+    if (out == NULL) return;
+    fclose(out);
+    counted_free(out_buffer);
+    out = NULL;
+    out_buffer = NULL;
+}
+
+// --- READER ---
+static int read_header(timeline_reader_t *r) {
+    uint8_t header[12];
+    if (fread(header, 1, sizeof(header), r->file) != sizeof(header) ||
+        memcmp(header, TIMELINE_MAGIC, 8) != 0) return -1;
+    r->lanes = (int)get_u32(header + 8);
+    r->last_start_us = 0;
+    return r->lanes > 0 ? 0 : -1;
+}
+
+int timeline_reader_open(timeline_reader_t *r, const char *path) {
+    r->file = fopen(path, "rb");
+    if (r->file == NULL) return -1;
+    if (read_header(r) != 0) {
+        fclose(r->file);
+        r->file = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void timeline_reader_close(timeline_reader_t *r) {
+    if (r->file != NULL) fclose(r->file);
+    r->file = NULL;
+}
+
+int timeline_reader_rewind(timeline_reader_t *r) {
+    rewind(r->file);
+    return read_header(r);
+}
+
+int timeline_reader_next(timeline_reader_t *r, timeline_interval_t *iv) {
+    int kind = getc(r->file);
+    if (kind == EOF) return 0;
+
+    uint64_t lane, car, dstart, duration;
+    if (read_varint(r->file, &lane) != 1 || read_varint(r->file, &car) != 1 ||
+        read_varint(r->file, &dstart) != 1 || read_varint(r->file, &duration) != 1) {
+        return -1;
+    }
+    if (kind >= TL_KINDS || lane >= (uint64_t)r->lanes) return -1;
+
+    r->last_start_us += unzigzag(dstart);
+    iv->kind = kind;
+    iv->lane = (int)lane;
+    iv->car_id = (int)unzigzag(car);
+    iv->start_us = r->last_start_us;
+    iv->duration_us = (int64_t)duration;
+    return 1;
+}
@@ -0,0 +1,73 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdint.h>     // Fixed-width fields of the file format
+#include <stdio.h>      // FILE for the reader
+
+// --- INTERVAL KINDS ---
+// What a lane was doing during an interval. The values are part of the
+// file format, so new kinds go at the end.
+//
+// The ferry lane goes through four phases per cycle:
+//   boarding      permits released, no car aboard yet (the ferry is idle)
+//   waiting_full  first car aboard until the last one fills the ferry
+//   crossing      departure until arrival at the other dock
+//   unboarding    arrival until the last car has left
+// Seat lanes hold one interval per car, from boarding to unboarding, so an
+// unboarding straggler is the seat bar that ends last in each unboarding
+// phase.
+typedef enum {
+    TL_BOARDING,
+    TL_WAITING_FULL,
+    TL_CROSSING,
+    TL_UNBOARDING,
+    TL_SEAT
+} timeline_kind_t;
+
+#define TL_KINDS 5
+
+const char *timeline_kind_name(int kind);
+
+// --- INTERVAL FILE FORMAT ---
+// "FERRYTL1", u32 lane count (lane 0 is the ferry, lane s + 1 is seat s),
+// then one record per interval, written when the interval ends:
+//   u8     kind
+//   varint lane
+//   varint zigzag(car_id)                        (-1 for ferry phases)
+//   varint zigzag(start_us - previous start_us)
+//   varint duration_us
+// Records of one lane are in time order; lanes interleave by end time.
+#define TIMELINE_MAGIC "FERRYTL1"
+#define TIMELINE_MAX_RECORD 41          // Longest encoded record
+
+typedef struct {
+    int kind;
+    int lane;
+    int car_id;
+    int64_t start_us;
+    int64_t duration_us;
+} timeline_interval_t;
+
+// --- WRITER ---
+int timeline_open(const char *path, int lanes);
+void timeline_interval(int kind, int lane, int car_id, double start_sec, double end_sec); // Thread-safe
+void timeline_close(void);
+
+// --- READER ---
+// Decodes records one at a time through stdio, so a reader never holds
+// more than the current interval, however long the run was.
+typedef struct {
+    FILE *file;
+    int lanes;
+    int64_t last_start_us;
+} timeline_reader_t;
+
+int timeline_reader_open(timeline_reader_t *r, const char *path);
+void timeline_reader_close(timeline_reader_t *r);
+int timeline_reader_rewind(timeline_reader_t *r);
+
+// Reads the next interval. Returns 1 on success, 0 at end of file, -1 on a
+// corrupt file.
+int timeline_reader_next(timeline_reader_t *r, timeline_interval_t *iv);
+
+#endif